@@ -0,0 +1,337 @@
+/*
+ * MPI microbenchmarks for calibrating the RoadMap work distribution.
+ *
+ * ./mpi-bench [width] [height]
+ *
+ * Measures, on whatever fabric the ranks were started on:
+ *   - ping-pong latency between rank 0 and rank 1
+ *   - ping-pong bandwidth versus message size
+ *   - many-to-one contention when every worker sends to rank 0 at once
+ *   - how many work requests per second a master polling with MPI_Iprobe
+ *     can serve (the RoadMapDynamic scheduling loop)
+ *   - the time it takes to compute one row of the RoadMap frame
+ *
+ * and combines them into a recommended work_rows value for RoadMapDynamic
+ * at the given frame width and height (defaults to 2000x2000).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "../complex_lib.h"
+
+#define MAX_ITERATIONS 100      // Same cut-off as RoadMap
+#define PINGPONG_ITERS 1000     // Round trips used for the latency test
+#define BW_MIN_BYTES   4        // Smallest message in the bandwidth sweep
+#define BW_MAX_BYTES   (1<<24)  // Largest message in the bandwidth sweep (16 MiB)
+#define BW_BYTES_MOVED (1<<26)  // Bytes to move per message size in the sweep
+#define GATHER_ROUNDS  50       // Rounds of all-to-master sends per message size
+#define PROBE_REQUESTS 2000     // Work requests each worker sends in the Iprobe test
+#define OVERHEAD_FRAC  0.05     // Accepted communication overhead per chunk
+#define CHUNKS_PER_WORKER 4     // Minimum chunks per worker to keep load balance
+#define DYNAMIC_WIDTH  2000     // Frame RoadMapDynamic is compiled for (WIDTH, HEIGHT there)
+#define DYNAMIC_HEIGHT 2000
+
+#define TAG_REQUEST 1
+#define TAG_REPLY   2
+#define TAG_DONE    3
+
+int width  = 2000;
+int height = 2000;
+
+/**
+ * Mandelbrot divergence test, identical to solve() in RoadMap.c
+ *
+ * @param       x,y     Space coordinates
+ * @returns     Number of iterations before convergance
+ */
+int solve(double x, double y)
+{
+    complex z = {0.0, 0.0};
+    complex c = {x, y};
+    int itt = 0;
+    for (itt = 0; (itt < MAX_ITERATIONS) && (complex_magn2(z) <= 4.0); itt++) {
+        z = complex_add(complex_squared(z), c);
+    }
+    return itt;
+}
+
+/**
+ * Half round trip time of a small message between rank 0 and rank 1.
+ *
+ * @returns     One-way latency in seconds (valid on rank 0 only)
+ */
+double bench_latency(int my_rank)
+{
+    int i, msg = 0;
+    double t0;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    t0 = MPI_Wtime();
+    for (i = 0; i < PINGPONG_ITERS; i++) {
+        if (my_rank == 0) {
+            MPI_Send(&msg, 1, MPI_INT, 1, TAG_REQUEST, MPI_COMM_WORLD);
+            MPI_Recv(&msg, 1, MPI_INT, 1, TAG_REPLY, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+        else if (my_rank == 1) {
+            MPI_Recv(&msg, 1, MPI_INT, 0, TAG_REQUEST, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            MPI_Send(&msg, 1, MPI_INT, 0, TAG_REPLY, MPI_COMM_WORLD);
+        }
+    }
+    return (MPI_Wtime() - t0) / (2.0 * PINGPONG_ITERS);
+}
+
+/**
+ * Ping-pong bandwidth between rank 0 and rank 1 for doubling message sizes.
+ * Prints one line per size on rank 0.
+ *
+ * @returns     Peak bandwidth in bytes/second over the sweep (rank 0 only)
+ */
+double bench_bandwidth(int my_rank, char *buf)
+{
+    int bytes, i, iters;
+    double t0, secs, bw, peak = 0.0;
+
+    if (my_rank == 0)
+        printf("%12s %12s %14s\n", "bytes", "usecs", "MB/s");
+
+    for (bytes = BW_MIN_BYTES; bytes <= BW_MAX_BYTES; bytes *= 2) {
+        iters = BW_BYTES_MOVED / bytes;
+        if (iters > PINGPONG_ITERS)
+            iters = PINGPONG_ITERS;
+        if (iters < 4)
+            iters = 4;
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        t0 = MPI_Wtime();
+        for (i = 0; i < iters; i++) {
+            if (my_rank == 0) {
+                MPI_Send(buf, bytes, MPI_CHAR, 1, TAG_REQUEST, MPI_COMM_WORLD);
+                MPI_Recv(buf, bytes, MPI_CHAR, 1, TAG_REPLY, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            }
+            else if (my_rank == 1) {
+                MPI_Recv(buf, bytes, MPI_CHAR, 0, TAG_REQUEST, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                MPI_Send(buf, bytes, MPI_CHAR, 0, TAG_REPLY, MPI_COMM_WORLD);
+            }
+        }
+        secs = (MPI_Wtime() - t0) / (2.0 * iters);
+        bw = bytes / secs;
+        if (bw > peak)
+            peak = bw;
+        if (my_rank == 0)
+            printf("%12d %12.2f %14.2f\n", bytes, secs * 1e6, bw / 1e6);
+    }
+    return peak;
+}
+
+/**
+ * All workers send a message of the same size to rank 0 at the same time,
+ * rank 0 receives them with MPI_ANY_SOURCE as RoadMapDynamic does.
+ * Prints one line per size on rank 0.
+ *
+ * @returns     Aggregate bytes/second received by rank 0 for one frame row
+ */
+double bench_gather(int my_rank, int comm_size, char *buf)
+{
+    int bytes, i, r;
+    int row_bytes = width * sizeof(int);
+    double t0, secs, bw, row_bw = 0.0;
+
+    if (my_rank == 0)
+        printf("%12s %12s %14s\n", "bytes", "usecs/msg", "MB/s at root");
+
+    for (bytes = row_bytes; bytes <= BW_MAX_BYTES && bytes <= 64 * row_bytes; bytes *= 2) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        t0 = MPI_Wtime();
+        for (r = 0; r < GATHER_ROUNDS; r++) {
+            if (my_rank == 0) {
+                for (i = 1; i < comm_size; i++)
+                    MPI_Recv(buf, bytes, MPI_CHAR, MPI_ANY_SOURCE, TAG_REQUEST, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            }
+            else {
+                MPI_Send(buf, bytes, MPI_CHAR, 0, TAG_REQUEST, MPI_COMM_WORLD);
+            }
+            // Keep the rounds apart so that every round really is a burst
+            MPI_Barrier(MPI_COMM_WORLD);
+        }
+        secs = (MPI_Wtime() - t0) / (GATHER_ROUNDS * (double)(comm_size - 1));
+        bw = bytes / secs;
+        if (bytes == row_bytes)
+            row_bw = bw;
+        if (my_rank == 0)
+            printf("%12d %12.2f %14.2f\n", bytes, secs * 1e6, bw / 1e6);
+    }
+    return row_bw;
+}
+
+/**
+ * Master loop polling with MPI_Iprobe and answering every request with a
+ * row index, the same pattern as the RoadMapDynamic scheduler.
+ *
+ * @returns     Requests served per second by rank 0 (rank 0 only)
+ */
+double bench_probe(int my_rank, int comm_size)
+{
+    int i, flag, msg = 0, done = 0;
+    double t0, secs;
+    MPI_Status status;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    t0 = MPI_Wtime();
+    if (my_rank == 0) {
+        int served = 0;
+        while (done < comm_size - 1) {
+            MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, &status);
+            if (!flag)
+                continue;
+            MPI_Recv(&msg, 1, MPI_INT, status.MPI_SOURCE, status.MPI_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            if (status.MPI_TAG == TAG_DONE) {
+                done++;
+                continue;
+            }
+            MPI_Send(&served, 1, MPI_INT, status.MPI_SOURCE, TAG_REPLY, MPI_COMM_WORLD);
+            served++;
+        }
+        secs = MPI_Wtime() - t0;
+        return served / secs;
+    }
+
+    for (i = 0; i < PROBE_REQUESTS; i++) {
+        MPI_Send(&msg, 1, MPI_INT, 0, TAG_REQUEST, MPI_COMM_WORLD);
+        MPI_Recv(&msg, 1, MPI_INT, 0, TAG_REPLY, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+    MPI_Send(&msg, 1, MPI_INT, 0, TAG_DONE, MPI_COMM_WORLD);
+    return 0.0;
+}
+
+/**
+ * Average time to compute one row of the first (most expensive to
+ * communicate, cheapest to compute) RoadMap frame. Every 16th row is sampled.
+ *
+ * @returns     Seconds per row
+ */
+double bench_row(void)
+{
+    int x, y, rows = 0;
+    volatile int sink = 0;
+    double box_x_min = -1.5, box_x_max = 0.5;
+    double box_y_min = -1.0, box_y_max = 1.0;
+    double t0 = MPI_Wtime();
+
+    for (y = 0; y < height; y += 16) {
+        for (x = 0; x < width; x++)
+            sink += solve(box_x_min + ((box_x_max - box_x_min) / width) * x,
+                          box_y_min + ((box_y_max - box_y_min) / height) * y);
+        rows++;
+    }
+    return (MPI_Wtime() - t0) / rows;
+}
+
+/**
+ * Smallest work_rows that keeps per-chunk communication below OVERHEAD_FRAC
+ * of the chunk's compute time and does not saturate the master, limited
+ * from above so that every worker gets at least CHUNKS_PER_WORKER chunks.
+ * RoadMapDynamic doesn't handle a partial last chunk, so the result is
+ * rounded up to a divisor of the height, or down to the largest divisor
+ * below the limit when there is none up to it (1 for a prime height).
+ */
+int recommend_rows(int workers, double latency, double bw, double gather_bw,
+                   double probe_rate, double row_secs)
+{
+    double row_comm = width * sizeof(int) / bw;
+    double row_master = width * sizeof(int) / gather_bw;
+    double r_eff = 1.0, r_master = 1.0, r_max;
+    int rows, d;
+
+    // Chunk cost: request + reply latency + payload, amortised over the rows
+    if (OVERHEAD_FRAC * row_secs > row_comm)
+        r_eff = 2.0 * latency / (OVERHEAD_FRAC * row_secs - row_comm);
+    else
+        r_eff = height;
+
+    // Master has to serve 'workers' chunks during the time one chunk takes
+    if (row_secs > workers * row_master)
+        r_master = workers / probe_rate / (row_secs - workers * row_master);
+    else
+        r_master = height;
+
+    r_max = height / (double)(CHUNKS_PER_WORKER * workers);
+    if (r_max < 1.0)
+        r_max = 1.0;
+
+    rows = (int)(r_eff > r_master ? r_eff : r_master) + 1;
+    if (rows > r_max)
+        rows = (int)r_max;
+    if (rows < 1)
+        rows = 1;
+    for (d = rows; d <= (int)r_max; d++)
+        if (height % d == 0)
+            return d;
+    while (height % rows != 0)
+        rows--;
+    return rows;
+}
+
+int main(int argc, char *argv[])
+{
+    int size, rank;
+    double latency, bw, gather_bw, probe_rate, row_secs;
+    char *buf;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (argc > 1)
+        width = atoi(argv[1]);
+    if (argc > 2)
+        height = atoi(argv[2]);
+    if (size < 2 || width <= 0 || height <= 0) {
+        if (rank == 0)
+            fprintf(stderr, "Usage: mpirun -np N (N >= 2) mpi-bench [width] [height]\n");
+        MPI_Finalize();
+        return 1;
+    }
+
+    buf = malloc(BW_MAX_BYTES);
+    memset(buf, 0, BW_MAX_BYTES);
+
+    if (rank == 0)
+        printf("# ping-pong latency (rank 0 <-> rank 1)\n");
+    latency = bench_latency(rank);
+    if (rank == 0)
+        printf("latency %.2f usecs\n\n# ping-pong bandwidth\n", latency * 1e6);
+
+    bw = bench_bandwidth(rank, buf);
+
+    if (rank == 0)
+        printf("\n# many-to-one (%d senders -> rank 0)\n", size - 1);
+    gather_bw = bench_gather(rank, size, buf);
+
+    if (rank == 0)
+        printf("\n# MPI_Iprobe master throughput (%d workers)\n", size - 1);
+    probe_rate = bench_probe(rank, size);
+
+    row_secs = bench_row();
+
+    if (rank == 0) {
+        int rows = recommend_rows(size - 1, latency, bw, gather_bw, probe_rate, row_secs);
+        printf("requests/s %.0f\n\n# RoadMap row of width %d\n", probe_rate, width);
+        printf("compute %.2f usecs/row\n\n", row_secs * 1e6);
+        printf("{'name' : 'mpi_bench', 'procs' : %d, 'width' : %d, 'height' : %d, "
+               "'latency_us' : %f, 'bw_MBs' : %f, 'gather_MBs' : %f, 'probe_rps' : %f, "
+               "'row_us' : %f, 'work_rows' : %d}\n",
+               size, width, height, latency * 1e6, bw / 1e6, gather_bw / 1e6, probe_rate,
+               row_secs * 1e6, rows);
+        if (width == DYNAMIC_WIDTH && height == DYNAMIC_HEIGHT)
+            printf("Recommended: mpirun -np %d RoadMapDynamic x %d\n", size, rows);
+        else
+            printf("Recommended work_rows %d, for a RoadMapDynamic built with WIDTH %d and HEIGHT %d "
+                   "(the one here is %dx%d)\n", rows, width, height, DYNAMIC_WIDTH, DYNAMIC_HEIGHT);
+    }
+
+    free(buf);
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,237 @@
+/*
+ * Best-first search for RaceTrap, see BestFirst.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Search.h"
+#include "BestFirst.h"
+#include "TransTable.h"
+
+long bestFirstNodes = 0;
+long bestFirstDives = 0;
+
+typedef struct {
+    OpenNode **chunks;      // BF_CHUNK nodes each
+    long       used;        // Nodes handed out
+    long       limit;       // Most nodes allowed
+    long       nChunks;     // Length of 'chunks'
+} NodePool;
+
+typedef struct {
+    int32_t *items;         // Pool indices, a binary min-heap on Before()
+    long     size;
+} OpenQueue;
+
+static inline OpenNode *PoolNode(NodePool *pool, long index)
+{
+    return &pool->chunks[index / BF_CHUNK][index % BF_CHUNK];
+}
+
+    // Makes sure that the next 'count' nodes can be handed out, false if
+    // that would go over the limit or there is no memory for them
+static int PoolReserve(NodePool *pool, long count)
+{
+    long c;
+
+    if (pool->used + count > pool->limit)
+        return 0;
+    for (c = pool->used / BF_CHUNK; c * BF_CHUNK < pool->used + count; c++)
+    {
+        if (pool->chunks[c] != NULL)
+            continue;
+        pool->chunks[c] = (OpenNode*) malloc(BF_CHUNK * sizeof(OpenNode));
+        if (pool->chunks[c] == NULL)
+        {
+            pool->limit = pool->used;   // Out of memory before the limit, dive from now on
+            return 0;
+        }
+    }
+    return 1;
+}
+
+    // A new node from the pool, after PoolReserve()
+static inline long PoolAlloc(NodePool *pool)
+{
+    return pool->used++;
+}
+
+static void PoolFree(NodePool *pool)
+{
+    long c;
+    for (c = 0; c < pool->nChunks; c++)
+        free(pool->chunks[c]);
+    free(pool->chunks);
+}
+
+    // Lower bound for a complete tour through the node. Equal bounds go to
+    // the node with more bags placed, which gets to a complete route sooner.
+static inline int Before(NodePool *pool, int32_t a, int32_t b)
+{
+    OpenNode *x = PoolNode(pool, a), *y = PoolNode(pool, b);
+    double kx = x->length + x->bound, ky = y->length + y->bound;
+
+    if (kx != ky)
+        return kx < ky;
+    return x->nPlaced > y->nPlaced;
+}
+
+static void Push(OpenQueue *q, NodePool *pool, int32_t node)
+{
+    long i = q->size++, parent;
+
+    while (i > 0 && Before(pool, node, q->items[parent = (i - 1) / 2]))
+    {
+        q->items[i] = q->items[parent];
+        i = parent;
+    }
+    q->items[i] = node;
+}
+
+static int32_t Pop(OpenQueue *q, NodePool *pool)
+{
+    int32_t top = q->items[0], last = q->items[--q->size];
+    long i = 0, child;
+
+    while ((child = 2 * i + 1) < q->size)
+    {
+        if (child + 1 < q->size && Before(pool, q->items[child + 1], q->items[child]))
+            child++;
+        if (!Before(pool, q->items[child], last))
+            break;
+        q->items[i] = q->items[child];
+        i = child;
+    }
+    q->items[i] = last;
+    return top;
+}
+
+    // Puts the partial route of 'node' in arena->path, followed by the bags it
+    // hasn't placed in increasing order
+static void PlacePath(SearchArena *arena, NodePool *pool, OpenNode *node)
+{
+    OpenNode *n = node;
+    int i, k = node->nPlaced;
+
+    for (i = k - 1; i >= 0; i--)
+    {
+        arena->path[i] = n->last;
+        if (n->parent >= 0)
+            n = PoolNode(pool, n->parent);
+    }
+    for (i = 0; i < nBags; i++)
+        if (!(node->mask >> i & 1))
+            arena->path[k++] = (unsigned char) i;
+}
+
+/*
+ * Best-first search from bag 0 with at most 'megabytes' of open nodes,
+ * returns the best route. 'seed' is as for ShortestRoute(). Falls back to
+ * ShortestRoute() for more than BF_MAX_BAGS bags.
+ */
+RouteDefinition *BestFirstRoute(RouteDefinition *seed, int megabytes)
+{
+    SearchArena *arena;
+    RouteDefinition *res;
+    NodePool pool;
+    OpenQueue queue;
+    SearchFrame child;
+    int32_t index;
+    int i, e;
+
+    if (nBags > BF_MAX_BAGS)
+    {
+        printf("Best-first search needs at most %d bags, searching depth-first\n", BF_MAX_BAGS);
+        return ShortestRoute(seed);
+    }
+
+    arena = Alloc_SearchArena();
+    res = Alloc_RouteDefinition();
+    STATS(statsStart = omp_get_wtime());
+    arena->progress = Progress_Ring(0);
+    SeedSearch(arena, seed);
+    Init_TransTable(TT_MEGABYTES);
+
+    pool.limit  = ((long) megabytes << 20) / (sizeof(OpenNode) + sizeof(int32_t));
+    if (pool.limit > INT32_MAX)
+        pool.limit = INT32_MAX;
+    pool.used   = 0;
+    pool.nChunks = pool.limit / BF_CHUNK + 1;
+    pool.chunks  = (OpenNode**) calloc(pool.nChunks, sizeof(OpenNode*));
+    queue.items = (int32_t*) malloc(pool.limit * sizeof(int32_t));
+    queue.size  = 0;
+    bestFirstDives = 0;
+
+    PoolReserve(&pool, 1);
+    index = PoolAlloc(&pool);
+    OpenNode *root = PoolNode(&pool, index);
+    root->mask    = 1;
+    root->length  = 0.0;
+    root->bound   = RootBound();
+    root->parent  = -1;
+    root->last    = 0;
+    root->nPlaced = 1;
+    Push(&queue, &pool, index);
+
+    while (queue.size > 0)
+    {
+        int32_t at = Pop(&queue, &pool);
+        OpenNode node = *PoolNode(&pool, at);
+
+            // Every node left is at least as long as this one
+        if (node.length + node.bound > ReadBest())
+            break;
+            // Out of time, the nodes left are the ones with this bound or more
+        if (SearchExpired())
+        {
+            AbandonWork(arena, node.length, node.bound);
+            break;
+        }
+
+        PlacePath(arena, &pool, &node);
+
+        if (!PoolReserve(&pool, nBags))
+        {
+                // Out of room for children, search this one depth-first
+            bestFirstDives++;
+            SearchFrom(arena, node.nPlaced, 0, nBags - 1, node.length, node.bound);
+            continue;
+        }
+
+        OpenFrame(arena, node.nPlaced, 0, nBags - 1, node.length, node.bound);
+        unsigned char *list = Neighbours(node.last);
+        for (e = 0; e < nBags - 1; e++)
+        {
+            i = arena->pos[list[e]];
+            if (i < node.nPlaced)
+                continue;
+            int kind = TryChild(arena, node.nPlaced, i, &child);
+            if (kind == CHILD_FAR)
+                break;
+            if (kind != CHILD_OPEN)
+                continue;
+
+            index = PoolAlloc(&pool);
+            OpenNode *n = PoolNode(&pool, index);
+            n->mask    = child.mask;
+            n->length  = child.length;
+            n->bound   = child.bound;
+            n->parent  = at;
+            n->last    = arena->path[i];
+            n->nPlaced = node.nPlaced + 1;
+            Push(&queue, &pool, index);
+        }
+    }
+
+    memcpy(res, arena->best, sizeof(RouteDefinition) + nBags);
+    nodesExpanded  = arena->nodes;
+    lowerBound     = arena->openBound < res->length ? arena->openBound : res->length;
+    bestFirstNodes = pool.used;
+    STATS(Collect_SearchStats(&arena->stats, 1, omp_get_wtime() - statsStart));
+    PoolFree(&pool);
+    free(queue.items);
+    Free_TransTable();
+    Free_SearchArena(arena);
+    return res;
+}
@@ -0,0 +1,41 @@
+/*
+ * Best-first search for RaceTrap, with depth-first dives once memory runs out.
+ *
+ * The open partial routes are kept in a priority queue ordered by their
+ * lower bound for a complete tour (length plus bound), and the most
+ * promising one is expanded next, with the same pruning as the depth-first
+ * search (TryChild() in Search.h). A node is stored compactly as the set
+ * of placed bags, the last bag, its length and bound and the node it was
+ * made from, in a pool that grows in chunks and is freed in one go.
+ *
+ * When the pool is full, nodes are taken from the queue in the same order
+ * but searched depth-first with SearchFrom(), starting from the path that
+ * the chain of parents gives. The search is over when the queue is empty or
+ * its best bound can't beat the best route any more.
+ */
+
+#ifndef BESTFIRST_H
+#define BESTFIRST_H
+
+#include <stdint.h>
+#include "Route.h"
+
+#define BF_MEGABYTES  256   // Default memory for the open nodes
+#define BF_MAX_BAGS   64    // The placed bags are a 64 bit mask
+#define BF_CHUNK      65536 // Nodes per pool chunk
+
+typedef struct {
+    uint64_t      mask;     // Bags placed, bit b for bag b
+    double        length;   // Length of the partial route
+    double        bound;    // Lower bound for the rest of the tour
+    int32_t       parent;   // Pool index of the node one bag shorter, -1 for bag 0
+    unsigned char last;     // Last bag placed
+    unsigned char nPlaced;  // Number of bags placed
+} OpenNode;
+
+extern long bestFirstNodes; // Nodes stored by the last BestFirstRoute()
+extern long bestFirstDives; // Depth-first dives it made once memory was full
+
+RouteDefinition *BestFirstRoute(RouteDefinition *seed, int megabytes);
+
+#endif
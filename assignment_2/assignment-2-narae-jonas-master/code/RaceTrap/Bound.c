@@ -0,0 +1,158 @@
+/*
+ * Lower bounds on the part of a RaceTrap tour that is not placed yet, see Bound.h.
+ */
+
+#include <stdlib.h>
+#include "Route.h"
+#include "Bound.h"
+
+double *minEdges = NULL;        // Shortest and second shortest edge of every bag
+
+    // Fills minEdges from the sorted neighbour lists, once per instance
+void InitMinEdges()
+{
+    int i;
+
+    free(minEdges);
+    minEdges = (double*) malloc(2 * nBags * sizeof(double));
+    for (i = 0; i < nBags; i++)
+    {
+        minEdges[2*i]   = Distance(i, Neighbours(i)[0]);
+        minEdges[2*i+1] = Distance(i, Neighbours(i)[nBags > 2 ? 1 : 0]);
+    }
+}
+
+/*
+ * Held-Karp lower bound for the path that leaves 'last', visits every bag in
+ * nodes[0..nNodes-1] except nodes[skip] (skip < 0 to use them all) and ends in
+ * 'first'. When first == last this is the classic 1-tree bound of a tour.
+ *
+ * pi[] holds the penalty of every bag. The bound is evaluated 'iterations'
+ * times, with a subgradient step on the penalties of the unvisited bags
+ * between evaluations, and the penalties that gave the best bound are left
+ * in pi[] to warm start the next call. Stops as soon as the bound exceeds
+ * 'target', since the caller prunes at that point anyway.
+ *
+ * Only uses the stack: the work arrays are sized by the number of bags.
+ */
+double OneTreeBound(int first, int last, unsigned char *nodes, int nNodes, int skip,
+                    double *pi, int iterations, double target)
+{
+    int m = 0, j, k, it;
+    double best = -maxRouteLen, lambda = 2.0;
+
+    if (nNodes - (skip >= 0) <= 0)
+        return Distance(last, first);
+
+    unsigned char u[nNodes];
+    for (j = 0; j < nNodes; j++)
+        if (j != skip)
+            u[m++] = nodes[j];
+
+    if (m == 1)
+        return Distance(last, u[0]) + Distance(u[0], first);
+
+    double key[m], bestPi[m];
+    int parent[m], deg[m];
+    char inTree[m];
+
+    for (j = 0; j < m; j++)
+        bestPi[j] = pi[u[j]];
+
+    for (it = 0; it < iterations || it == 0; it++)
+    {
+        double total = 0.0, piSum = 0.0, endA, endB, bound;
+        int jA = 0, jB = 0, norm = 0;
+
+            // Prim's minimum spanning tree of the unvisited bags, with penalties
+        for (j = 0; j < m; j++)
+        {
+            key[j] = maxRouteLen;
+            inTree[j] = 0;
+            deg[j] = 0;
+            piSum += pi[u[j]];
+        }
+        key[0] = 0.0;
+        parent[0] = -1;
+        for (k = 0; k < m; k++)
+        {
+            int jMin = -1;
+            for (j = 0; j < m; j++)
+                if (!inTree[j] && (jMin < 0 || key[j] < key[jMin]))
+                    jMin = j;
+            inTree[jMin] = 1;
+            total += key[jMin];
+            if (parent[jMin] >= 0)
+            {
+                deg[jMin]++;
+                deg[parent[jMin]]++;
+            }
+            for (j = 0; j < m; j++)
+            {
+                if (inTree[j])
+                    continue;
+                double w = Distance(u[jMin], u[j]) + pi[u[jMin]] + pi[u[j]];
+                if (w < key[j])
+                {
+                    key[j] = w;
+                    parent[j] = jMin;
+                }
+            }
+        }
+
+            // Cheapest edge from each end of the path into the tree. With a
+            // single end these have to go to two different bags.
+        endA = endB = maxRouteLen;
+        for (j = 0; j < m; j++)
+        {
+            double wA = Distance(first, u[j]) + pi[u[j]];
+            if (wA < endA)
+            {
+                endA = wA;
+                jA = j;
+            }
+        }
+        for (j = 0; j < m; j++)
+        {
+            double wB = Distance(last, u[j]) + pi[u[j]];
+            if (wB < endB && (first != last || j != jA))
+            {
+                endB = wB;
+                jB = j;
+            }
+        }
+        deg[jA]++;
+        deg[jB]++;
+
+        bound = total + endA + endB - 2 * piSum;
+        if (bound > best)
+        {
+            best = bound;
+            for (j = 0; j < m; j++)
+                bestPi[j] = pi[u[j]];
+        }
+        else
+            lambda /= 2;
+
+        if (best > target)
+            break;
+
+        for (j = 0; j < m; j++)
+            norm += (deg[j] - 2) * (deg[j] - 2);
+        if (norm == 0)
+            break;      // The tree is a path through all of them, nothing to tighten
+
+            // Polyak step towards the bound we need to prune, or a guess
+            // a bit above the current bound when there is no incumbent yet.
+        double goal = target < maxRouteLen / 2 ? target : 1.1 * bound;
+        double t = lambda * (goal - bound) / norm;
+        if (t <= 0.0)
+            break;
+        for (j = 0; j < m; j++)
+            pi[u[j]] += t * (deg[j] - 2);
+    }
+
+    for (j = 0; j < m; j++)
+        pi[u[j]] = bestPi[j];
+    return best;
+}
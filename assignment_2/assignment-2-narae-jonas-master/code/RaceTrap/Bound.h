@@ -0,0 +1,56 @@
+/*
+ * Lower bounds on the part of a RaceTrap tour that is not placed yet.
+ *
+ * firstMin/secondMin are the shortest and second shortest edge at a bag,
+ * cached by InitMinEdges() for the half-sum bound of RaceTrapLB: every
+ * bag that is not placed yet still has two edges in the tour, and each
+ * end of the partial route one, so the rest of the tour is at least half
+ * the sum of those shortest edges. MinEdgeChild() updates that sum in
+ * O(1) when a bag is placed.
+ *
+ * OneTreeBound is the Held-Karp bound: the rest of a tour that has placed
+ * path[0..k] is a path from the last placed bag through all unvisited bags
+ * back to path[0]. Without its two end edges that is a spanning path of
+ * the unvisited bags, so it is at least as long as their minimum spanning
+ * tree plus the shortest edge from each end into the tree. Adding a
+ * penalty pi[v] to every edge at an unvisited bag v adds exactly
+ * 2*sum(pi) to every such path, so the bound stays valid for any
+ * penalties, and subgradient steps on pi (raise it at bags the tree uses
+ * more than twice, lower it at leaves) tighten it.
+ */
+
+#ifndef BOUND_H
+#define BOUND_H
+
+#define HK_ROOT_ITERS 200   // Subgradient iterations for the penalties at the root
+#define HK_NODE_ITERS 3     // Subgradient iterations per search node, warm started
+
+extern double *minEdges;    // firstMin and secondMin of every bag, in pairs
+
+void InitMinEdges();
+
+static inline double firstMin(int i)
+{
+    return minEdges[2*i];
+}
+
+static inline double secondMin(int i)
+{
+    return minEdges[2*i+1];
+}
+
+    // Half-sum bound for the rest of the tour after placing bag 'to' after
+    // bag 'from' at position 'depth', from the bound 'bound' of the parent.
+    // Bag 'to' loses one of its two unplaced edges, and 'from' stops being
+    // an end of the partial route (at depth 1 it is bag 0, which had two).
+static inline double MinEdgeChild(double bound, int depth, int from, int to)
+{
+    if (depth == 1)
+        return bound - (secondMin(from) + secondMin(to)) / 2;
+    return bound - (firstMin(from) + secondMin(to)) / 2;
+}
+
+double OneTreeBound(int first, int last, unsigned char *nodes, int nNodes, int skip,
+                    double *pi, int iterations, double target);
+
+#endif
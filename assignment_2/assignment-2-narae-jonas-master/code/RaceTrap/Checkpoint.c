@@ -0,0 +1,219 @@
+/*
+ * Checkpoints of a RaceTrap search, see Checkpoint.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "Route.h"
+#include "Search.h"
+#include "WorkDeque.h"
+#include "Checkpoint.h"
+
+double checkpointInterval = 0.0;
+int    resumeSearch = 0;
+int    checkpointsWritten = 0;
+double checkpointPause = 0.0;
+long   resumedWork = 0;
+long   resumedNodes = 0;
+
+typedef struct {
+    char     magic[4];      // "RTCK"
+    int32_t  version;
+    int32_t  nBags;
+    int32_t  boundMode;
+    uint64_t routeHash;     // Of the coordinates, see RouteHash()
+    int64_t  nodes;         // Nodes looked at by all runs until the checkpoint
+    int64_t  nWork;         // Subproblem records after the best route
+    double   length;        // Of the best route, which follows the header
+} CheckpointHeader;
+
+    // Size of a record without its path
+#define RECORD_SIZE (2 * sizeof(double) + 3)
+
+static pthread_t writer;
+static int   writing = 0;   // A writer thread was started and not joined yet
+static int   busy = 0;      // It is still writing
+static char *image = NULL;  // What it writes
+static size_t imageSize;
+
+    // FNV-1a over the number of bags, the coordinates and the rounding
+static uint64_t RouteHash()
+{
+    uint64_t h = 14695981039346656037ULL;
+    int values[3], i, k;
+
+    for (i = -1; i < nBags; i++)
+    {
+        values[0] = i < 0 ? nBags : bagCoords[i].x;
+        values[1] = i < 0 ? roundDistances : bagCoords[i].y;
+        for (k = 0; k < 2 * (int) sizeof(int); k++)
+        {
+            h ^= ((unsigned char*) values)[k];
+            h *= 1099511628211ULL;
+        }
+    }
+    return h;
+}
+
+static void *Writer(void *arg)
+{
+    FILE *file = fopen(CKPT_FILE ".tmp", "wb");
+    int ok = file != NULL;
+
+    if (ok)
+    {
+        ok = fwrite(image, 1, imageSize, file) == imageSize && fflush(file) == 0 &&
+             fsync(fileno(file)) == 0;
+        ok = fclose(file) == 0 && ok;
+    }
+    if (ok)
+        ok = rename(CKPT_FILE ".tmp", CKPT_FILE) == 0;
+    if (!ok)
+        fprintf(stderr, "Warning: couldn't write the checkpoint %s\n", CKPT_FILE);
+    __atomic_store_n(&busy, 0, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+    // True while the previous checkpoint is still being written
+int CheckpointBusy()
+{
+    return __atomic_load_n(&busy, __ATOMIC_ACQUIRE);
+}
+
+    // Waits for the checkpoint being written, if any
+void Finish_Checkpoints()
+{
+    if (!writing)
+        return;
+    pthread_join(writer, NULL);
+    writing = 0;
+    free(image);
+    image = NULL;
+}
+
+/*
+ * Packs the best route and the 'nWork' subproblems in 'work' (slots of
+ * Subproblem_Size()) and starts writing them to CKPT_FILE. Waits for the
+ * previous checkpoint first if it isn't written yet. 'work' may be reused
+ * when this returns.
+ */
+void WriteCheckpoint(RouteDefinition *best, char *work, long nWork, long nodes)
+{
+    CheckpointHeader header;
+    char *p;
+    long i;
+
+    Finish_Checkpoints();
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "RTCK", 4);
+    header.version   = CKPT_VERSION;
+    header.nBags     = nBags;
+    header.boundMode = boundMode;
+    header.routeHash = RouteHash();
+    header.nodes     = nodes;
+    header.nWork     = nWork;
+    header.length    = best->length;
+
+    imageSize = sizeof(header) + nBags;
+    for (i = 0; i < nWork; i++)
+        imageSize += RECORD_SIZE + ((Subproblem*) (work + i * Subproblem_Size()))->nPlaced;
+    image = (char*) malloc(imageSize);
+
+    p = image;
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    memcpy(p, best->path, nBags);
+    p += nBags;
+    for (i = 0; i < nWork; i++)
+    {
+        Subproblem *s = (Subproblem*) (work + i * Subproblem_Size());
+        memcpy(p, &s->length, sizeof(double));
+        memcpy(p + sizeof(double), &s->bound, sizeof(double));
+        p += 2 * sizeof(double);
+        *p++ = s->nPlaced;
+        *p++ = s->next;
+        *p++ = s->end;
+        memcpy(p, s->path, s->nPlaced);
+        p += s->nPlaced;
+    }
+
+    checkpointsWritten++;
+    busy    = 1;
+    writing = 1;
+    pthread_create(&writer, NULL, Writer, NULL);
+}
+
+/*
+ * Reads CKPT_FILE into 'best', and its subproblems into '*work' (malloc'ed,
+ * slots of Subproblem_Size()), the unplaced bags of every path in increasing
+ * order. Returns the number of subproblems, also left in resumedWork.
+ * Stops the program if the file is missing or was written for another
+ * route or bound.
+ */
+long ReadCheckpoint(RouteDefinition *best, char **work)
+{
+    FILE *file = fopen(CKPT_FILE, "rb");
+    CheckpointHeader header;
+    unsigned char placed[MAX_BAGS];
+    double values[2];
+    long i;
+    int b, k;
+
+    if (file == NULL || fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, "RTCK", 4) != 0 || header.version != CKPT_VERSION)
+    {
+        printf("Error: no checkpoint to resume from in %s.\n", CKPT_FILE);
+        exit(-1);
+    }
+    if (header.nBags != nBags || header.routeHash != RouteHash() || header.boundMode != boundMode)
+    {
+        printf("Error: %s was written for another route or bound (%s).\n", CKPT_FILE,
+               header.boundMode >= BOUND_NONE && header.boundMode <= BOUND_ONETREE ?
+               BoundModeName(header.boundMode) : "?");
+        exit(-1);
+    }
+
+    best->length  = header.length;
+    best->nPlaced = nBags;
+    resumedNodes = header.nodes;
+    *work  = (char*) malloc((header.nWork + 1) * Subproblem_Size());
+    if (fread(best->path, 1, nBags, file) != (size_t) nBags)
+        header.nWork = -1;
+    for (i = 0; i < header.nWork; i++)
+    {
+        Subproblem *s = (Subproblem*) (*work + i * Subproblem_Size());
+        unsigned char counts[3];
+
+        if (fread(values, sizeof(double), 2, file) != 2 || fread(counts, 1, 3, file) != 3 ||
+            counts[0] > nBags || fread(s->path, 1, counts[0], file) != counts[0])
+        {
+            header.nWork = -1;
+            break;
+        }
+        s->length  = values[0];
+        s->bound   = values[1];
+        s->nPlaced = counts[0];
+        s->next    = counts[1];
+        s->end     = counts[2];
+            // The search doesn't care in what order the unplaced bags are
+        memset(placed, 0, nBags);
+        for (k = 0; k < s->nPlaced; k++)
+            placed[s->path[k]] = 1;
+        for (b = 0; b < nBags; b++)
+            if (!placed[b])
+                s->path[k++] = (unsigned char) b;
+    }
+    fclose(file);
+    if (header.nWork < 0)
+    {
+        printf("Error: %s is cut short.\n", CKPT_FILE);
+        exit(-1);
+    }
+    resumedWork = header.nWork;
+    return header.nWork;
+}
@@ -0,0 +1,44 @@
+/*
+ * Checkpoints of a RaceTrap search, to resume it after it was killed.
+ *
+ * What is left of a depth-first search is the untried children of its open
+ * frames and the subproblems waiting in the deques, each of which is a
+ * Subproblem (WorkDeque.h): a partial route and a range of its children.
+ * With the best route so far that is all a new run needs to go on where
+ * the old one stopped. ShortestRoutePar() collects them every
+ * checkpointInterval seconds, while all threads wait at their next poll
+ * (see Search.c), and hands them to WriteCheckpoint(), which packs them and
+ * leaves the writing to a thread of its own so the search goes on at once.
+ *
+ * The file holds a header (format version, the number of bags, the bound
+ * mode and a hash of the coordinates, which all have to match to resume),
+ * the best route, and one record per subproblem with only the placed bags
+ * of its path. It is written to a temporary file first and renamed, so a
+ * run killed while writing leaves the previous checkpoint in place.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "Route.h"
+
+#define CKPT_FILE     "racetrap.ckpt"
+#define CKPT_INTERVAL 10.0  // Default seconds between checkpoints
+#define CKPT_VERSION  1
+
+extern double checkpointInterval; // Seconds between checkpoints, 0 for none
+extern int    resumeSearch;       // True to start from CKPT_FILE instead of bag 0
+extern int    checkpointsWritten; // Checkpoints taken by the last search
+extern double checkpointPause;    // Seconds the last search stood still for them
+extern long   resumedWork;        // Subproblems read by the last ReadCheckpoint()
+extern long   resumedNodes;       // Nodes the runs before it had looked at
+
+int CheckpointBusy();
+
+void WriteCheckpoint(RouteDefinition *best, char *work, long nWork, long nodes);
+
+long ReadCheckpoint(RouteDefinition *best, char **work);
+
+void Finish_Checkpoints();
+
+#endif
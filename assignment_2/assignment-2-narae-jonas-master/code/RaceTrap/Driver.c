@@ -0,0 +1,240 @@
+/*
+ * Command line driver of the RaceTrap programs, see Driver.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "Timer.h"
+#include "Route.h"
+#include "Search.h"
+#include "Heuristic.h"
+#include "HeldKarp.h"
+#include "TransTable.h"
+#include "LeafSolver.h"
+#include "BestFirst.h"
+#include "Checkpoint.h"
+#include "Incremental.h"
+#include "SearchStats.h"
+#include "MaskSearch.h"
+#include "Portfolio.h"
+#include "Progress.h"
+#include "Driver.h"
+#include <omp.h>
+
+int RaceDriver(int argc, char **argv, const char *name, int mode)
+{
+    RouteDefinition *res, *seed = NULL, *repaired = NULL;
+    char *tourFile = NULL, *deltaFile = NULL;  // incremental re-solve
+    double tDelta = 0.0;
+    char buf[256];
+    int warmStart = 1;
+    int parallel = mode == DRIVER_PARALLEL;
+    int nThreads = parallel ? omp_get_max_threads() : 1;  // OMP_NUM_THREADS, or every core
+    double budget = 0.0;    // seconds for the whole run, 0 for no limit
+    char *statsFile = NULL; // JSON statistics of the search, SearchStats.h
+    double elapsed;
+    int timers = -1;        // clock of the timer report, -1 for no report
+    int useDP = 0;
+    int bestFirst = 0;  // megabytes for best-first search, 0 for depth-first
+    int useMask = 0;    // bitmask engine, MaskSearch.h
+    int portfolio = -1; // heuristic threads next to the search, -1 for none
+    int progress = 0;   // report when the first, a good and the best route were found
+
+    // ./<name> [dump] [cold] [dp] [bestfirst[=MB]] [mask] [round] [tt[=depth]] [leaf=bags] [budget=seconds] [checkpoint[=seconds]] [resume] [tour=file delta=file] [stats[=file]] [timers[=monotonic|tsc]] [progress] [none|minedge|onetree]
+    // and in parallel: [threads=N] [grain=bags] [portfolio[=threads]]
+    for (int i = 1; i < argc; i++) {
+        if (strcmp("dump", argv[i]) == 0) {
+            DO_DUMP = 1;
+        }
+        else if (strcmp("cold", argv[i]) == 0) {
+            warmStart = 0;  // no heuristic route before the search
+        }
+        else if (strcmp("dp", argv[i]) == 0) {
+            useDP = 1;      // Held-Karp dynamic programming instead of the search
+        }
+        else if (strncmp("bestfirst", argv[i], 9) == 0 && (argv[i][9] == '\0' || argv[i][9] == '=')) {
+            bestFirst = argv[i][9] ? ParseCount(argv[i], 1, INT_MAX) : BF_MEGABYTES;  // best-first search
+        }
+        else if (strcmp("mask", argv[i]) == 0) {
+            useMask = 1;    // search with bitmask nodes, up to 64 bags
+        }
+        else if (strcmp("round", argv[i]) == 0) {
+            roundDistances = 1;  // integer distances, like TSPLIB
+        }
+        else if (strncmp("tt", argv[i], 2) == 0 && (argv[i][2] == '\0' || argv[i][2] == '=')) {
+            ttDepth = argv[i][2] ? atoi(argv[i] + 3) : TT_DEFAULT_DEPTH;  // dominance table
+        }
+        else if (parallel && strncmp("threads=", argv[i], 8) == 0) {
+            nThreads = ParseCount(argv[i], 1, INT_MAX);
+        }
+        else if (parallel && strncmp("portfolio", argv[i], 9) == 0 && (argv[i][9] == '\0' || argv[i][9] == '=')) {
+            portfolio = argv[i][9] ? ParseCount(argv[i], 0, INT_MAX) : 1;  // local search threads feed the search
+        }
+        else if (parallel && strncmp("grain=", argv[i], 6) == 0) {
+            splitGrain = ParseCount(argv[i], 1, INT_MAX);  // fewest unplaced bags to hand to another thread
+        }
+        else if (strncmp("budget=", argv[i], 7) == 0) {
+            budget = atof(argv[i] + 7);    // anytime mode: stop searching after this long
+        }
+        else if (strncmp("checkpoint", argv[i], 10) == 0 && (argv[i][10] == '\0' || argv[i][10] == '=')) {
+            checkpointInterval = argv[i][10] ? atof(argv[i] + 11) : CKPT_INTERVAL;  // save the work left
+        }
+        else if (strncmp("stats", argv[i], 5) == 0 && (argv[i][5] == '\0' || argv[i][5] == '=')) {
+            statsFile = argv[i][5] ? argv[i] + 6 : STATS_FILE;  // counters of the search as JSON
+        }
+        else if (strncmp("timers", argv[i], 6) == 0 && (argv[i][6] == '\0' || argv[i][6] == '=')) {
+            timers = argv[i][6] ? ParseTimerBackend(argv[i] + 7) : TIMER_MONOTONIC;  // where the time went
+            if (timers < 0) {
+                printf("Unknown timer %s\n", argv[i] + 7);
+                exit(-1);
+            }
+        }
+        else if (strcmp("progress", argv[i]) == 0) {
+            progress = 1;   // keep the time of every new best route
+        }
+        else if (strcmp("resume", argv[i]) == 0) {
+            resumeSearch = 1;   // go on from the last checkpoint
+        }
+        else if (strncmp("tour=", argv[i], 5) == 0) {
+            tourFile = argv[i] + 5;    // best tour before the changes
+        }
+        else if (strncmp("delta=", argv[i], 6) == 0) {
+            deltaFile = argv[i] + 6;   // bags added, moved or removed since
+        }
+        else if (strncmp("leaf=", argv[i], 5) == 0) {
+            leafBags = ParseCount(argv[i], 0, LEAF_MAX);  // try all orders of the last bags
+        }
+        else if (ParseBoundMode(argv[i]) >= 0) {
+            boundMode = ParseBoundMode(argv[i]);
+        }
+        else {
+            printf("Unknown argument %s for %s\n", argv[i], name);
+            exit(-1);
+        }
+    }
+    if (portfolio >= nThreads) {
+        printf("portfolio=%d leaves none of the %d threads to the search, it takes 0 to %d\n",
+               portfolio, nThreads, nThreads - 1);
+        exit(-1);
+    }
+        // Only one solver runs, and only the depth-first search takes checkpoints
+    if (useDP + (bestFirst > 0) + (useMask || portfolio >= 0) > 1) {
+        printf("Pick one of dp, bestfirst and mask or portfolio for %s\n", name);
+        exit(-1);
+    }
+    if ((checkpointInterval > 0 || resumeSearch) && (useDP || bestFirst > 0 || useMask)) {
+        printf("checkpoint and resume need the depth-first search, not %s\n",
+               useDP ? "dp" : bestFirst > 0 ? "bestfirst" : "mask");
+        exit(-1);
+    }
+    if (leafBags > 0 && (useDP || useMask)) {
+        printf("leaf= needs the depth-first or best-first search, not %s\n", useDP ? "dp" : "mask");
+        exit(-1);
+    }
+
+    Init_Timers(timers > 0 ? timers : TIMER_MONOTONIC);
+    Timer_Start("read route");
+    if (deltaFile != NULL && tourFile != NULL)
+    {
+            // The changed route, and the old tour repaired to start from
+        tDelta = omp_get_wtime();
+        repaired = IncrementalRoute(tourFile, deltaFile);
+        tDelta = omp_get_wtime() - tDelta;
+    }
+    else if (deltaFile != NULL || tourFile != NULL)
+    {
+        printf("Error: the incremental re-solve needs both tour= and delta=\n");
+        exit(-1);
+    }
+    else
+        ReadRoute();
+    Timer_Stop();
+
+        // Set up an initial path that goes through each bag in turn.
+    res = Alloc_RouteDefinition();
+    for (int i = 0; i < nBags; i++)
+        res->path[i] = (unsigned char) i;
+    dump_data(res);
+    free(res);
+
+    Timer_Start("solve");
+    omp_set_num_threads(nThreads);
+    if (budget > 0)
+        searchDeadline = omp_get_wtime() + budget;
+        // New best routes go to a writer thread, the search doesn't wait for the output
+    if (DO_DUMP || budget > 0 || portfolio >= 0 || progress)
+        Start_Progress(omp_get_max_threads(), budget > 0);
+        // Start from a good route, so that the search prunes from the start
+    if (repaired != NULL)
+        seed = repaired;
+    else if (warmStart && !useDP && portfolio < 0)
+    {
+        Timer_Start("heuristic");
+        seed = HeuristicRoute();
+        Timer_Stop();
+    }
+        // Find the best route
+    Timer_Start("search");
+    if (useDP)
+        res = HeldKarpRoute();
+    else if (portfolio >= 0)
+        res = PortfolioRoute(portfolio, useMask);
+    else if (useMask)
+        res = MaskRoute(seed);
+    else if (bestFirst > 0)
+        res = BestFirstRoute(seed, bestFirst);
+    else if (parallel)
+        res = ShortestRoutePar(seed);
+    else
+        res = ShortestRoute(seed);
+    Timer_Stop();
+    Stop_Progress();
+    elapsed = Timer_Stop();
+    TimeString(elapsed, buf);
+    if (res == NULL)
+        exit(-1);
+    dump_data(res);
+
+    printf("Route length is %lf it took %s\n", res->length, buf);
+    if (!useDP && parallel)
+        printf("Looked at %ld nodes with bound %s on %d threads\n", nodesExpanded, BoundModeName(boundMode), nThreads);
+    else if (!useDP)
+        printf("Looked at %ld nodes with bound %s\n", nodesExpanded, BoundModeName(boundMode));
+    if (bestFirst > 0 && !useDP)
+        printf("Stored %ld open nodes, %ld depth-first dives\n", bestFirstNodes, bestFirstDives);
+    if (repaired != NULL)
+        printf("Applied %d changes and repaired the old tour in %.3f ms, length %lf\n",
+               bagChanges, tDelta * 1000, repaired->length);
+    else if (seed != NULL)
+        printf("Heuristic route length was %lf\n", seed->length);
+    if (portfolio >= 0 && !useDP)
+        PortfolioReport(res);
+    else if (progress && !useDP)
+        ProgressReport(res->length, nThreads);
+    if (resumeSearch && !useDP)
+        printf("Resumed %ld subproblems left after %ld nodes\n", resumedWork, resumedNodes);
+    if (checkpointInterval > 0 && !useDP)
+        printf("Wrote %d checkpoints, the search waited %.3f ms for them (%.3f%%)\n", checkpointsWritten,
+               checkpointPause * 1000, 100.0 * checkpointPause / elapsed);
+    if (budget > 0 && !useDP)
+        printf("Lower bound is %lf, gap %.3f%%%s\n", lowerBound,
+               100.0 * (res->length - lowerBound) / res->length,
+               searchStopped ? ", stopped at the time budget" : "");
+
+    if (statsFile != NULL && !useDP && WriteSearchStats(statsFile))
+        printf("Wrote the search statistics to %s\n", statsFile);
+    if (deltaFile != NULL)
+        WriteIncremental(res);
+
+    if (timers >= 0)
+        Timer_Report(stdout);
+
+    if (DO_DUMP) {
+        close_dump();
+    }
+
+    return 0;
+}
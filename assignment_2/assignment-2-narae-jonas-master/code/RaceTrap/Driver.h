@@ -0,0 +1,20 @@
+/*
+ * Command line driver shared by RaceTrap, RaceTrapHybrid and RaceTrapLB.
+ *
+ * RaceDriver() parses the arguments, reads the route, runs the solver they
+ * pick and prints the report. The programs only differ in their defaults:
+ * a sequential driver runs ShortestRoute() on one thread and refuses the
+ * thread options (threads=, grain=, portfolio=), a parallel one runs
+ * ShortestRoutePar() on threads=N threads. Set boundMode before calling
+ * it for a default bound other than none.
+ */
+
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#define DRIVER_SEQUENTIAL 0
+#define DRIVER_PARALLEL   1
+
+int RaceDriver(int argc, char **argv, const char *name, int mode);
+
+#endif
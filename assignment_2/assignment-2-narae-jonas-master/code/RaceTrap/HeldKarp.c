@@ -0,0 +1,200 @@
+/*
+ * Held-Karp dynamic programming solver for RaceTrap, see HeldKarp.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <float.h>
+#include <unistd.h>
+#include <omp.h>
+#include "HeldKarp.h"
+#include "Heuristic.h"
+
+/*
+ * Memory layout: the bags other than bag 0 are bits 0..m-1 of a mask, bag
+ * b is bit b-1. For every mask there are m float costs and m predecessor
+ * bytes, one per possible last bag, indexed mask * m + bit.
+ */
+size_t HeldKarpBytes(int bags)
+{
+    size_t m = bags - 1;
+    return ((size_t)1 << m) * m * (sizeof(float) + sizeof(unsigned char))
+        + bags * bags * sizeof(float);
+}
+
+static uint64_t binomial[HK_MAX_BAGS + 1][HK_MAX_BAGS + 1];  // binomial[n][k], n over k
+
+static void Init_Binomials()
+{
+    int n, k;
+
+    for (n = 0; n <= HK_MAX_BAGS; n++)
+    {
+        binomial[n][0] = 1;
+        for (k = 1; k <= n; k++)
+            binomial[n][k] = binomial[n-1][k-1] + (k < n ? binomial[n-1][k] : 0);
+    }
+}
+
+    // The masks of k bits below bit m, in increasing order, are numbered
+    // from 0; returns number r, highest bit first (combinatorial number system)
+static uint32_t NthMask(uint64_t r, int k, int m)
+{
+    uint32_t set = 0;
+    int c = m - 1;
+
+    for (; k > 0; k--, c--)
+    {
+        while (binomial[c][k] > r)
+            c--;
+        set |= (uint32_t)1 << c;
+        r -= binomial[c][k];
+    }
+    return set;
+}
+
+    // The next larger mask with as many bits (Gosper's hack)
+static inline uint32_t NextMask(uint32_t set)
+{
+    uint32_t low = set & -set, ripple = set + low;
+    return ripple | (((set ^ ripple) >> 2) / low);
+}
+
+    // Half of the physical memory of this machine
+static size_t MemoryLimit()
+{
+    return (size_t) sysconf(_SC_PHYS_PAGES) * (size_t) sysconf(_SC_PAGESIZE) / 2;
+}
+
+/*
+ * Solves the route exactly with the Held-Karp recursion
+ *   cost(S, j) = min over i in S-{j} of cost(S-{j}, i) + d(i, j)
+ * layer by layer, the masks of a layer (only those, in chunks of HK_CHUNK)
+ * spread over the OpenMP threads.
+ * Returns the shortest route starting at bag 0, or NULL (after saying so)
+ * when the tables would not fit in memory.
+ */
+RouteDefinition *HeldKarpRoute()
+{
+    RouteDefinition *res = Alloc_RouteDefinition();
+    int m = nBags - 1, i, j, k;
+    size_t bytes, full, mask;
+
+    res->nPlaced = nBags;
+    for (i = 0; i < nBags; i++)
+        res->path[i] = (unsigned char) i;
+    if (nBags <= 2)
+    {
+        res->length = TourLength(res->path);
+        return res;
+    }
+
+    bytes = HeldKarpBytes(nBags);
+    printf("Held-Karp tables for %d bags take %.1f MB\n", nBags, bytes / 1e6);
+    if (nBags > HK_MAX_BAGS || bytes > MemoryLimit())
+    {
+        printf("Error: that is more than the %.1f MB allowed (at most %d bags)\n",
+               MemoryLimit() / 1e6, HK_MAX_BAGS);
+        free(res);
+        return NULL;
+    }
+
+    full = ((size_t)1 << m) - 1;
+    Init_Binomials();
+    float *cost = (float*) malloc((full + 1) * m * sizeof(float));
+    unsigned char *pred = (unsigned char*) malloc((full + 1) * m);
+    float *dist = (float*) malloc(nBags * nBags * sizeof(float));
+    if (cost == NULL || pred == NULL || dist == NULL)
+    {
+        printf("Error: couldn't allocate the Held-Karp tables\n");
+        exit(-1);
+    }
+
+    for (i = 0; i < nBags; i++)
+        for (j = 0; j < nBags; j++)
+            dist[i * nBags + j] = (float) Distance(i, j);
+
+        // Layer 1: straight from bag 0
+    for (j = 0; j < m; j++)
+    {
+        cost[((size_t)1 << j) * m + j] = dist[j + 1];
+        pred[((size_t)1 << j) * m + j] = (unsigned char) m;   // m marks bag 0
+    }
+
+    for (k = 2; k <= m; k++)
+    {
+        uint64_t count = binomial[m][k];
+        long chunks = (long) ((count + HK_CHUNK - 1) / HK_CHUNK), c;
+
+            // Only the masks of k bits, HK_CHUNK at a time from the first of each chunk on
+        #pragma omp parallel for schedule(dynamic, 1) private(i, j)
+        for (c = 0; c < chunks; c++)
+        {
+            uint64_t r = (uint64_t) c * HK_CHUNK;
+            uint64_t end = count - r < HK_CHUNK ? count : r + HK_CHUNK;
+            uint32_t set = NthMask(r, k, m), bits, prevBits;
+
+            for (;;)
+            {
+                size_t cur = set;
+
+                for (bits = set; bits; bits &= bits - 1)
+                {
+                    j = __builtin_ctz(bits);
+                    size_t prev = cur ^ ((size_t)1 << j);
+                    float best = FLT_MAX;
+                    int arg = 0;
+
+                    for (prevBits = (uint32_t) prev; prevBits; prevBits &= prevBits - 1)
+                    {
+                        i = __builtin_ctz(prevBits);
+                        float len = cost[prev * m + i] + dist[(i + 1) * nBags + j + 1];
+                        if (len < best)
+                        {
+                            best = len;
+                            arg = i;
+                        }
+                    }
+                    cost[cur * m + j] = best;
+                    pred[cur * m + j] = (unsigned char) arg;
+                }
+                if (++r == end)
+                    break;
+                set = NextMask(set);
+            }
+        }
+    }
+
+        // Close the loop back to bag 0
+    float best = FLT_MAX;
+    int last = 0;
+    for (j = 0; j < m; j++)
+    {
+        float c = cost[full * m + j] + dist[(j + 1) * nBags];
+        if (c < best)
+        {
+            best = c;
+            last = j;
+        }
+    }
+
+        // Walk the predecessors back from the last bag
+    mask = full;
+    for (k = nBags - 1; k >= 1; k--)
+    {
+        res->path[k] = (unsigned char) (last + 1);
+        i = pred[mask * m + last];
+        mask ^= (size_t)1 << last;
+        last = i;
+    }
+    res->path[0] = 0;
+
+        // Length in double precision, summed like the search does
+    res->length = TourLength(res->path);
+
+    free(cost);
+    free(pred);
+    free(dist);
+    return res;
+}
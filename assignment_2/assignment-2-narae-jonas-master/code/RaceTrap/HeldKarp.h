@@ -0,0 +1,24 @@
+/*
+ * Held-Karp dynamic programming solver for RaceTrap.
+ *
+ * cost(S, j) is the length of the shortest path that starts in bag 0,
+ * visits exactly the bags in S and ends in bag j. It only depends on the
+ * sets with one bag less, so all sets of the same size (one layer) are
+ * computed in parallel. O(n^2 * 2^n) time whatever the instance looks
+ * like, which makes it the predictable choice for 15-25 bags.
+ */
+
+#ifndef HELDKARP_H
+#define HELDKARP_H
+
+#include <stddef.h>
+#include "Route.h"
+
+#define HK_MAX_BAGS 31      // Sets of the other bags are 32 bit masks
+#define HK_CHUNK    1024    // Masks of a layer a thread takes at a time
+
+size_t HeldKarpBytes(int bags);
+
+RouteDefinition *HeldKarpRoute();
+
+#endif
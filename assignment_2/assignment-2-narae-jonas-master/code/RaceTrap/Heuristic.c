@@ -0,0 +1,221 @@
+/*
+ * Construction and local search heuristics for RaceTrap, see Heuristic.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "Heuristic.h"
+
+#define EPSILON 1e-9  // Smallest gain that counts as an improvement
+
+    // Length of the closed tour, summed in the same order as the search does
+double TourLength(unsigned char *tour)
+{
+    int i;
+    double length = 0.0;
+
+    for (i = 1; i < nBags; i++)
+        length += Distance(tour[i-1], tour[i]);
+    return length + Distance(tour[nBags-1], tour[0]);
+}
+
+    // Builds a tour from 'start' by always going to the closest unvisited bag
+double NearestNeighbour(int start, unsigned char *tour)
+{
+    char visited[nBags];
+    int i, j, cur = start;
+
+    memset(visited, 0, nBags);
+    visited[start] = 1;
+    tour[0] = (unsigned char) start;
+    for (i = 1; i < nBags; i++)
+    {
+        int next = -1;
+        for (j = 0; j < nBags; j++)
+            if (!visited[j] && (next < 0 || Distance(cur, j) < Distance(cur, next)))
+                next = j;
+        visited[next] = 1;
+        tour[i] = (unsigned char) next;
+        cur = next;
+    }
+    return TourLength(tour);
+}
+
+    // Reverses tour[i..j]
+static void Reverse(unsigned char *tour, int i, int j)
+{
+    unsigned char tmp;
+    for (; i < j; i++, j--)
+    {
+        tmp = tour[i]; tour[i] = tour[j]; tour[j] = tmp;
+    }
+}
+
+/*
+ * 2-opt: replaces edges (a,b) and (c,d) by (a,c) and (b,d), reversing the
+ * part in between, whenever that is shorter. Repeats until no such pair is
+ * left. Returns true if the tour was changed.
+ */
+int TwoOpt(unsigned char *tour)
+{
+    int i, j, changed = 0, improved = 1;
+
+    while (improved)
+    {
+        improved = 0;
+        for (i = 0; i < nBags - 2; i++)
+        {
+            int a = tour[i], b = tour[i+1];
+            for (j = i + 2; j < nBags; j++)
+            {
+                int c = tour[j], d = tour[(j+1) % nBags];
+                if (d == a)
+                    continue;
+                double delta = Distance(a, c) + Distance(b, d)
+                             - Distance(a, b) - Distance(c, d);
+                if (delta < -EPSILON)
+                {
+                    Reverse(tour, i + 1, j);
+                    b = tour[i+1];
+                    improved = changed = 1;
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+/*
+ * Or-opt: moves a segment of 1, 2 or 3 consecutive bags to the place in the
+ * tour where it is cheapest, in either direction, whenever that is shorter.
+ * Repeats until no move helps. Returns true if the tour was changed.
+ */
+int OrOpt(unsigned char *tour)
+{
+    unsigned char rest[nBags];
+    int len, i, k, changed = 0, improved = 1;
+
+    while (improved)
+    {
+        improved = 0;
+        for (len = 1; len <= 3 && len + 2 < nBags; len++)
+        {
+            for (i = 0; i < nBags; i++)
+            {
+                int s0 = tour[i], sL = tour[(i + len - 1) % nBags];
+                int p = tour[(i + nBags - 1) % nBags], q = tour[(i + len) % nBags];
+                int nRest = nBags - len, bestK = -1, bestRev = 0;
+                double gain = Distance(p, s0) + Distance(sL, q) - Distance(p, q);
+                double bestCost = gain - EPSILON;
+
+                    // The tour without the segment, from q around to p
+                for (k = 0; k < nRest; k++)
+                    rest[k] = tour[(i + len + k) % nBags];
+
+                    // Insert between rest[k] and rest[k+1]; between p and q is where it came from
+                for (k = 0; k < nRest - 1; k++)
+                {
+                    int x = rest[k], y = rest[k+1];
+                    double cost = Distance(x, s0) + Distance(sL, y) - Distance(x, y);
+                    double costRev = Distance(x, sL) + Distance(s0, y) - Distance(x, y);
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestK = k;
+                        bestRev = 0;
+                    }
+                    if (costRev < bestCost)
+                    {
+                        bestCost = costRev;
+                        bestK = k;
+                        bestRev = 1;
+                    }
+                }
+                if (bestK < 0)
+                    continue;
+
+                unsigned char seg[3];
+                for (k = 0; k < len; k++)
+                    seg[k] = tour[(i + k) % nBags];
+                memcpy(tour, rest, bestK + 1);
+                for (k = 0; k < len; k++)
+                    tour[bestK + 1 + k] = bestRev ? seg[len - 1 - k] : seg[k];
+                memcpy(tour + bestK + 1 + len, rest + bestK + 1, nRest - bestK - 1);
+                improved = changed = 1;
+            }
+        }
+    }
+    return changed;
+}
+
+    // 2-opt and Or-opt until neither improves the tour
+double LocalSearch(unsigned char *tour)
+{
+    if (nBags >= 4)
+    {
+        TwoOpt(tour);
+        while (OrOpt(tour) && TwoOpt(tour))
+            ;
+    }
+    return TourLength(tour);
+}
+
+    // Rotates the tour to start at bag 0 and turns it around if needed, so
+    // that it leaves bag 0 for the nearer of its two neighbours, like the
+    // routes of the search (the order of the neighbour list of bag 0)
+void RotateToStart(unsigned char *tour)
+{
+    unsigned char tmp[nBags];
+    int i, at = 0;
+
+    while (tour[at] != 0)
+        at++;
+    for (i = 0; i < nBags; i++)
+        tmp[i] = tour[(at + i) % nBags];
+    memcpy(tour, tmp, nBags);
+    if (nBags > 2 && (Distance(0, tour[1]) > Distance(0, tour[nBags-1]) ||
+                      (Distance(0, tour[1]) == Distance(0, tour[nBags-1]) && tour[1] > tour[nBags-1])))
+        Reverse(tour, 1, nBags - 1);
+}
+
+/*
+ * Nearest neighbour from every bag, each improved with 2-opt and Or-opt.
+ * The start bags are spread over the OpenMP threads. Returns the shortest
+ * of the tours, starting at bag 0; equal lengths are decided by the path so
+ * the result doesn't depend on the threads.
+ */
+RouteDefinition *HeuristicRoute()
+{
+    RouteDefinition *best = Alloc_RouteDefinition();
+    int start;
+
+    best->length  = maxRouteLen;
+    best->nPlaced = nBags;
+
+    #pragma omp parallel
+    {
+        unsigned char tour[nBags];
+        double length;
+
+        #pragma omp for schedule(dynamic, 1)
+        for (start = 0; start < nBags; start++)
+        {
+            NearestNeighbour(start, tour);
+            LocalSearch(tour);
+            RotateToStart(tour);
+            length = TourLength(tour);
+
+            #pragma omp critical (heuristic)
+            {
+                if (length < best->length ||
+                    (length == best->length && memcmp(tour, best->path, nBags) < 0))
+                {
+                    best->length = length;
+                    memcpy(best->path, tour, nBags);
+                }
+            }
+        }
+    }
+    return best;
+}
@@ -0,0 +1,28 @@
+/*
+ * Construction and local search heuristics for RaceTrap.
+ *
+ * Used to find a good route before the exact search starts, so that
+ * globalBest prunes from the first dive instead of starting at maxRouteLen.
+ * A tour is an array of nBags bag numbers, closed back to its first bag.
+ */
+
+#ifndef HEURISTIC_H
+#define HEURISTIC_H
+
+#include "Route.h"
+
+double TourLength(unsigned char *tour);
+
+double NearestNeighbour(int start, unsigned char *tour);
+
+int TwoOpt(unsigned char *tour);
+
+int OrOpt(unsigned char *tour);
+
+double LocalSearch(unsigned char *tour);
+
+void RotateToStart(unsigned char *tour);
+
+RouteDefinition *HeuristicRoute();
+
+#endif
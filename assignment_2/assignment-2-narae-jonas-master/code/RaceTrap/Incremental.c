@@ -0,0 +1,160 @@
+/*
+ * Incremental re-solve of a RaceTrap route, see Incremental.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Route.h"
+#include "Heuristic.h"
+#include "Incremental.h"
+
+int bagChanges = 0;
+
+    // Reads the tour of the route before the change, nBags bag numbers
+static void ReadTour(const char *name, unsigned char *tour)
+{
+    FILE *file = fopen(name, "r");
+    char seen[MAX_BAGS];
+    int i, b;
+
+    if (file == NULL)
+    {
+        printf("Error: couldn't open the tour %s.\n", name);
+        exit(-1);
+    }
+    memset(seen, 0, sizeof(seen));
+    for (i = 0; i < nBags; i++)
+    {
+        if (fscanf(file, "%d", &b) != 1 || b < 0 || b >= nBags || seen[b])
+        {
+            printf("Error: %s is not a tour of the %d bags of the route.\n", name, nBags);
+            exit(-1);
+        }
+        seen[b] = 1;
+        tour[i] = (unsigned char) b;
+    }
+    fclose(file);
+}
+
+    // Takes 'bag' out of the tour of 'n' bags, returns n-1
+static int TakeOut(unsigned char *tour, int n, int bag)
+{
+    int i, k = 0;
+
+    for (i = 0; i < n; i++)
+        if (tour[i] != bag)
+            tour[k++] = tour[i];
+    return k;
+}
+
+    // Puts 'bag' into the tour of 'n' bags between the two neighbours where
+    // it adds the least length, returns n+1
+static int CheapestInsertion(unsigned char *tour, int n, int bag)
+{
+    double best = 0.0;
+    int i, at = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        int a = tour[i], b = tour[(i + 1) % n];
+        double added = Distance(a, bag) + Distance(bag, b) - Distance(a, b);
+        if (i == 0 || added < best)
+        {
+            best = added;
+            at = i + 1;
+        }
+    }
+    memmove(tour + at + 1, tour + at, n - at);
+    tour[at] = (unsigned char) bag;
+    return n + 1;
+}
+
+/*
+ * Reads the route as ReadRoute() does, and the tour 'tourFile' of it.
+ * Applies the changes of 'deltaFile' to both and returns the repaired
+ * route, starting at bag 0 like the routes of the search.
+ */
+RouteDefinition *IncrementalRoute(const char *tourFile, const char *deltaFile)
+{
+    unsigned char tour[MAX_BAGS];
+    RouteDefinition *res;
+    FILE *delta;
+    char line[256], op[16];
+    int n, i, bag;
+    Coord at;
+
+    ReadRoute();
+    ReadTour(tourFile, tour);
+    n = nBags;
+
+    delta = fopen(deltaFile, "r");
+    if (delta == NULL)
+    {
+        printf("Error: couldn't open the delta %s.\n", deltaFile);
+        exit(-1);
+    }
+    bagChanges = 0;
+    while (fgets(line, sizeof(line), delta) != NULL)
+    {
+        if (sscanf(line, "%15s", op) != 1 || op[0] == '#')
+            continue;
+        if (strcmp(op, "add") == 0 && sscanf(line, "%*s %d %d", &at.x, &at.y) == 2)
+        {
+            bag = AddBag(at);
+            n = CheapestInsertion(tour, n, bag);
+        }
+        else if (strcmp(op, "move") == 0 && sscanf(line, "%*s %d %d %d", &bag, &at.x, &at.y) == 3 &&
+                 bag >= 0 && bag < nBags)
+        {
+            MoveBag(bag, at);
+            n = TakeOut(tour, n, bag);
+            n = CheapestInsertion(tour, n, bag);
+        }
+        else if (strcmp(op, "remove") == 0 && sscanf(line, "%*s %d", &bag) == 1 &&
+                 bag >= 0 && bag < nBags && nBags > 1)
+        {
+            RemoveBag(bag);
+            n = TakeOut(tour, n, bag);
+            for (i = 0; i < n; i++)
+                if (tour[i] > bag)
+                    tour[i]--;
+        }
+        else
+        {
+            printf("Error: can't apply '%.*s' of %s to %d bags.\n",
+                   (int) strcspn(line, "\n"), line, deltaFile, nBags);
+            exit(-1);
+        }
+        bagChanges++;
+    }
+    fclose(delta);
+
+    res = Alloc_RouteDefinition();
+    LocalSearch(tour);
+    RotateToStart(tour);
+    memcpy(res->path, tour, nBags);
+    res->nPlaced = nBags;
+    res->length  = TourLength(tour);
+    return res;
+}
+
+    // Writes the changed route to INC_ROUTE_FILE and 'route' to INC_TOUR_FILE,
+    // to start the next change from
+void WriteIncremental(RouteDefinition *route)
+{
+    FILE *file;
+    int i;
+
+    WriteRoute(INC_ROUTE_FILE);
+    file = fopen(INC_TOUR_FILE, "w");
+    if (file == NULL)
+    {
+        printf("Error: couldn't write %s.\n", INC_TOUR_FILE);
+        return;
+    }
+    for (i = 0; i < nBags; i++)
+        fprintf(file, "%d ", route->path[i]);
+    fprintf(file, "\n");
+    fclose(file);
+}
@@ -0,0 +1,34 @@
+/*
+ * Incremental re-solve of a RaceTrap route after a few bags changed.
+ *
+ * Given the best tour of the route before the change and a delta file of
+ * changes, applied in order:
+ *
+ *     add x y          a new bag, numbered after the others
+ *     move bag x y     new coordinates for a bag
+ *     remove bag       takes a bag out, the bags after it move down one
+ *
+ * the route is updated in place (AddBag(), MoveBag() and RemoveBag() in
+ * Route.h compute only the distances of the changed bag) and the old tour
+ * is repaired to match: removed bags are left out and added or moved bags
+ * are put back where they add the least length (cheapest insertion). 2-opt
+ * and Or-opt then finish the repair. The result is a complete route close to
+ * the new optimum, often the optimum itself, that the exact search starts
+ * from, so that it prunes nearly everything from the first node.
+ */
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "Route.h"
+
+#define INC_ROUTE_FILE "route.next"  // The changed route, for the next change
+#define INC_TOUR_FILE  "tour.next"   // Its best tour
+
+extern int bagChanges;      // Changes applied by the last IncrementalRoute()
+
+RouteDefinition *IncrementalRoute(const char *tourFile, const char *deltaFile);
+
+void WriteIncremental(RouteDefinition *route);
+
+#endif
@@ -0,0 +1,186 @@
+/*
+ * 2-d tree for nearest bag queries, see KdTree.h.
+ */
+
+#include <stdlib.h>
+#include <omp.h>
+#include "KdTree.h"
+
+#define TASK_SIZE 16384     // Ranges at least this long are built as a separate task
+
+static inline double Coordinate(Point *p, int d)
+{
+    return d == 0 ? p->x : p->y;
+}
+
+    // Rearranges index[lo..hi) so that index[k] has the bag that belongs
+    // there in order of coordinate 'd', smaller ones before it (quickselect)
+static void Select(KdTree *tree, int lo, int hi, int k, int d)
+{
+    int *index = tree->index;
+
+    while (hi - lo > 1)
+    {
+        double pivot = Coordinate(&tree->points[index[lo + (hi - lo) / 2]], d);
+        int i = lo, j = hi - 1, tmp;
+
+        while (i <= j)
+        {
+            while (Coordinate(&tree->points[index[i]], d) < pivot)
+                i++;
+            while (Coordinate(&tree->points[index[j]], d) > pivot)
+                j--;
+            if (i <= j)
+            {
+                tmp = index[i]; index[i] = index[j]; index[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+        if (k <= j)
+            hi = j + 1;
+        else if (k >= i)
+            lo = i;
+        else
+            return;
+    }
+}
+
+static void Build(KdTree *tree, int lo, int hi)
+{
+    double minX, maxX, minY, maxY;
+    int i, mid = lo + (hi - lo) / 2, d;
+
+    if (hi - lo <= 1)
+    {
+        if (hi > lo)
+            tree->dim[lo] = 0;
+        return;
+    }
+
+    minX = maxX = tree->points[tree->index[lo]].x;
+    minY = maxY = tree->points[tree->index[lo]].y;
+    for (i = lo + 1; i < hi; i++)
+    {
+        Point *p = &tree->points[tree->index[i]];
+        if (p->x < minX) minX = p->x;
+        if (p->x > maxX) maxX = p->x;
+        if (p->y < minY) minY = p->y;
+        if (p->y > maxY) maxY = p->y;
+    }
+    d = maxY - minY > maxX - minX;
+    Select(tree, lo, hi, mid, d);
+    tree->dim[mid] = (unsigned char) d;
+
+        // The two halves don't overlap
+    #pragma omp task if (mid - lo >= TASK_SIZE)
+    Build(tree, lo, mid);
+    Build(tree, mid + 1, hi);
+    #pragma omp taskwait
+}
+
+    // Builds the tree over the 'n' bags at 'points', with the OpenMP threads
+void Build_KdTree(KdTree *tree, Point *points, int n)
+{
+    int i;
+
+    tree->points = points;
+    tree->n      = n;
+    tree->index  = (int*) malloc(n * sizeof(int));
+    tree->dim    = (unsigned char*) malloc(n);
+    for (i = 0; i < n; i++)
+        tree->index[i] = i;
+
+    #pragma omp parallel
+    #pragma omp single
+    Build(tree, 0, n);
+}
+
+void Free_KdTree(KdTree *tree)
+{
+    free(tree->index);
+    free(tree->dim);
+}
+
+typedef struct {
+    Point  *from;       // The bag the nearest ones are wanted for
+    int     self;
+    int     k;
+    int     found;
+    int    *nearest;    // The 'found' nearest so far, nearest first
+    double *dist;       // Their squared distances
+} Query;
+
+    // Adds bag 'p' to the query if it is among the k nearest so far;
+    // equal distances are ordered by bag number
+static void Offer(Query *q, int p, double dist)
+{
+    int i;
+
+    if (q->found == q->k &&
+        (dist > q->dist[q->k - 1] || (dist == q->dist[q->k - 1] && p > q->nearest[q->k - 1])))
+        return;
+    if (q->found < q->k)
+        q->found++;
+    for (i = q->found - 1; i > 0 &&
+         (q->dist[i-1] > dist || (q->dist[i-1] == dist && q->nearest[i-1] > p)); i--)
+    {
+        q->dist[i]    = q->dist[i-1];
+        q->nearest[i] = q->nearest[i-1];
+    }
+    q->dist[i]    = dist;
+    q->nearest[i] = p;
+}
+
+static void Search(KdTree *tree, Query *q, int lo, int hi)
+{
+    while (hi > lo)
+    {
+        int mid = lo + (hi - lo) / 2, p = tree->index[mid], d = tree->dim[mid];
+        Point *at = &tree->points[p];
+        double dx = at->x - q->from->x, dy = at->y - q->from->y;
+        double diff = Coordinate(q->from, d) - Coordinate(at, d);
+
+        if (p != q->self)
+            Offer(q, p, dx*dx + dy*dy);
+
+            // The side 'from' is on first, the other only if it can be nearer
+        if (diff < 0)
+        {
+            Search(tree, q, lo, mid);
+            if (q->found < q->k || diff * diff <= q->dist[q->k - 1])
+                lo = mid + 1;
+            else
+                return;
+        }
+        else
+        {
+            Search(tree, q, mid + 1, hi);
+            if (q->found < q->k || diff * diff <= q->dist[q->k - 1])
+                hi = mid;
+            else
+                return;
+        }
+    }
+}
+
+/*
+ * Puts the 'k' nearest other bags of bag 'i' in 'nearest', nearest first,
+ * and returns how many there are (fewer than k only if there are no more).
+ */
+int NearestPoints(KdTree *tree, int i, int k, int *nearest)
+{
+    double dist[k > 0 ? k : 1];
+    Query q;
+
+    if (k <= 0)
+        return 0;
+    q.from    = &tree->points[i];
+    q.self    = i;
+    q.k       = k;
+    q.found   = 0;
+    q.nearest = nearest;
+    q.dist    = dist;
+    Search(tree, &q, 0, tree->n);
+    return q.found;
+}
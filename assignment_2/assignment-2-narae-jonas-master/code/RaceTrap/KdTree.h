@@ -0,0 +1,31 @@
+/*
+ * A 2-d tree over the bags of a large instance, for nearest bag queries.
+ *
+ * The tree is implicit: 'index' holds the bag numbers so that the bag in
+ * the middle of any range of it splits the rest of the range, those before
+ * it on the smaller side. The split of the range is across the wider of
+ * its two extents, recorded in 'dim' at the middle position. Building takes
+ * O(n log n) and a query for the k nearest bags looks at O(log n + k) bags
+ * for evenly spread bags. Queries only read the tree, so any number of
+ * threads can make them at once.
+ */
+
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include "LargeRoute.h"
+
+typedef struct {
+    Point         *points;  // The coordinates the tree was built over
+    int           *index;   // Bag numbers in tree order
+    unsigned char *dim;     // Split of the range with its middle here, 0 for x and 1 for y
+    int            n;
+} KdTree;
+
+void Build_KdTree(KdTree *tree, Point *points, int n);
+
+void Free_KdTree(KdTree *tree);
+
+int NearestPoints(KdTree *tree, int i, int k, int *nearest);
+
+#endif
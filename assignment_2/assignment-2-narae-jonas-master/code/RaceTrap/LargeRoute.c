@@ -0,0 +1,236 @@
+/*
+ * Reading and candidate lists for large RaceTrap instances, see LargeRoute.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+#include "LargeRoute.h"
+#include "KdTree.h"
+
+int     nPoints = 0;            // Number of bags
+Point  *points = NULL;          // Their coordinates
+int     nCandidates = 0;        // Length of the candidate list of every bag
+int    *candidates = NULL;      // The nCandidates nearest other bags of every bag, nearest first
+
+static int IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static const char *SkipSpace(const char *p, const char *end)
+{
+    while (p < end && IsSpace(*p))
+        p++;
+    return p;
+}
+
+    // Parses a decimal number at 'p' (after white space) into 'v', returns
+    // the character after it or NULL if there is none. The file is not
+    // null terminated, so strtod() can't be used on it.
+static const char *ParseNumber(const char *p, const char *end, double *v)
+{
+    double value = 0.0, scale = 1.0;
+    int negative = 0, digits = 0, exponent = 0, expNegative = 0;
+
+    p = SkipSpace(p, end);
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    for (; p < end && *p >= '0' && *p <= '9'; p++, digits++)
+        value = value * 10.0 + (*p - '0');
+    if (p < end && *p == '.')
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++)
+        {
+            scale /= 10.0;
+            value += (*p - '0') * scale;
+        }
+    if (digits == 0)
+        return NULL;
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+        if (p < end && (*p == '-' || *p == '+'))
+            expNegative = *p++ == '-';
+        for (; p < end && *p >= '0' && *p <= '9'; p++)
+            exponent = exponent * 10 + (*p - '0');
+        value *= pow(10.0, expNegative ? -exponent : exponent);
+    }
+    *v = negative ? -value : value;
+    return p;
+}
+
+    // The line after the one 'p' is in
+static const char *NextLine(const char *p, const char *end)
+{
+    while (p < end && *p != '\n')
+        p++;
+    return p < end ? p + 1 : end;
+}
+
+    // True if the line at 'p' starts with 'key'
+static int HasKey(const char *p, const char *end, const char *key)
+{
+    size_t len = strlen(key);
+    return (size_t) (end - p) >= len && memcmp(p, key, len) == 0;
+}
+
+    // The value after the ':' of the line at 'p'
+static const char *KeyValue(const char *p, const char *end)
+{
+    while (p < end && *p != ':' && *p != '\n')
+        p++;
+    if (p < end && *p == ':')
+        p++;
+    return SkipSpace(p, end);
+}
+
+static void AllocPoints(double n)
+{
+    if (n < 1 || n > 1e8)
+    {
+        printf("Error: invalid number of bags %.0f.\n", n);
+        exit(-1);
+    }
+    nPoints = (int) n;
+    points = (Point*) malloc(nPoints * sizeof(Point));
+}
+
+    // route.dat: the number of bags followed by one coordinate pair per bag
+static void ParseRouteDat(const char *p, const char *end)
+{
+    double n;
+    int i;
+
+    if ((p = ParseNumber(p, end, &n)) == NULL)
+    {
+        printf("Error: couldn't read number of bags from route definition file.\n");
+        exit(-1);
+    }
+    AllocPoints(n);
+    for (i = 0; i < nPoints; i++)
+    {
+        if ((p = ParseNumber(p, end, &points[i].x)) == NULL ||
+            (p = ParseNumber(p, end, &points[i].y)) == NULL)
+        {
+            printf("Error: missing or invalid definition of coordinate %d.\n", i);
+            exit(-1);
+        }
+    }
+}
+
+    // TSPLIB: "KEY : VALUE" lines, then "id x y" lines after NODE_COORD_SECTION
+static void ParseTsplib(const char *p, const char *end)
+{
+    double n = 0.0, id;
+    int i;
+
+    for (; p < end; p = NextLine(p, end))
+    {
+        p = SkipSpace(p, end);
+        if (HasKey(p, end, "DIMENSION"))
+            ParseNumber(KeyValue(p, end), end, &n);
+        else if (HasKey(p, end, "EDGE_WEIGHT_TYPE"))
+        {
+            const char *v = KeyValue(p, end);
+            if (!HasKey(v, end, "EUC_2D"))
+            {
+                printf("Error: only EUC_2D TSPLIB instances are supported.\n");
+                exit(-1);
+            }
+            roundDistances = 1;
+        }
+        else if (HasKey(p, end, "NODE_COORD_SECTION"))
+            break;
+    }
+    if (p >= end || n == 0.0)
+    {
+        printf("Error: no DIMENSION or NODE_COORD_SECTION in TSPLIB file.\n");
+        exit(-1);
+    }
+    p = NextLine(p, end);
+
+    AllocPoints(n);
+    for (i = 0; i < nPoints; i++)
+    {
+        if ((p = ParseNumber(p, end, &id)) == NULL ||
+            (p = ParseNumber(p, end, &points[i].x)) == NULL ||
+            (p = ParseNumber(p, end, &points[i].y)) == NULL)
+        {
+            printf("Error: missing or invalid definition of coordinate %d.\n", i);
+            exit(-1);
+        }
+    }
+}
+
+/*
+ * Reads the bags from the file 'name', which is mapped into memory and
+ * parsed in place. A file that starts with a number is in the route.dat
+ * format, anything else is taken to be TSPLIB.
+ */
+void ReadLargeRoute(const char *name)
+{
+    struct stat st;
+    const char *data, *p, *end;
+    int fd = open(name, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        printf("Error: couldn't read route definition file %s.\n", name);
+        exit(-1);
+    }
+    data = (const char*) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        printf("Error: couldn't map route definition file %s.\n", name);
+        exit(-1);
+    }
+    madvise((void*) data, st.st_size, MADV_SEQUENTIAL);
+    end = data + st.st_size;
+
+    p = SkipSpace(data, end);
+    if (p < end && ((*p >= '0' && *p <= '9') || *p == '+'))
+        ParseRouteDat(p, end);
+    else
+        ParseTsplib(p, end);
+
+    munmap((void*) data, st.st_size);
+    close(fd);
+}
+
+    // Fills the candidate lists with the 'k' nearest bags of every bag
+void BuildCandidates(int k)
+{
+    KdTree tree;
+    int i;
+
+    if (k > nPoints - 1)
+        k = nPoints - 1;
+    nCandidates = k;
+    candidates = (int*) malloc((size_t) nPoints * k * sizeof(int) + 1);
+    if (candidates == NULL)
+    {
+        printf("Error: couldn't allocate %d candidates for %d bags.\n", k, nPoints);
+        exit(-1);
+    }
+
+    Build_KdTree(&tree, points, nPoints);
+        // Every query only reads the tree
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (i = 0; i < nPoints; i++)
+        NearestPoints(&tree, i, k, Candidates(i));
+    Free_KdTree(&tree);
+}
+
+void FreeLargeRoute()
+{
+    free(points);
+    free(candidates);
+    points = NULL;
+    candidates = NULL;
+    nPoints = nCandidates = 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * Instances too large for the exact search (RaceTrapLarge).
+ *
+ * RouteDefinition keeps bag numbers in unsigned chars and Route.c builds a
+ * full nBags x nBags distance table, which limits the other variants to
+ * MAX_BAGS bags. Here bags are ints, coordinates are kept as they are read
+ * and distances are computed when needed. Instead of sorting all other bags
+ * of every bag, each bag gets a short list of its nearest bags, found with
+ * a k-d tree (KdTree.h); the local search only looks at those.
+ *
+ * ReadLargeRoute() reads the route.dat format (the number of bags, then one
+ * "x y" pair per bag) or a TSPLIB file with a NODE_COORD_SECTION. For TSPLIB
+ * the EDGE_WEIGHT_TYPE must be EUC_2D, which sets roundDistances.
+ */
+
+#ifndef LARGEROUTE_H
+#define LARGEROUTE_H
+
+#include <math.h>
+#include "Route.h"
+
+#define LARGE_CANDIDATES 8  // Default length of the candidate lists
+#define LARGE_MAX_CANDIDATES 64  // Longest candidate lists k= takes
+
+typedef struct {
+    double x;
+    double y;
+} Point;
+
+extern int     nPoints;         // Number of bags
+extern Point  *points;          // Their coordinates
+extern int     nCandidates;     // Length of the candidate list of every bag
+extern int    *candidates;      // The nCandidates nearest other bags of every bag, nearest first
+
+    // Distance between bag 'i' and bag 'j', rounded like Distance() with roundDistances
+static inline double PointDistance(int i, int j)
+{
+    double dx = points[i].x - points[j].x;
+    double dy = points[i].y - points[j].y;
+    double d = sqrt(dx*dx + dy*dy);
+    return roundDistances ? (int) (d + 0.5) : d;
+}
+
+    // The candidate list of bag 'i'
+static inline int *Candidates(int i)
+{
+    return candidates + i * nCandidates;
+}
+
+void ReadLargeRoute(const char *name);
+
+void BuildCandidates(int k);
+
+void FreeLargeRoute();
+
+#endif
@@ -0,0 +1,490 @@
+/*
+ * Heuristic tours for large RaceTrap instances, see LargeTour.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <omp.h>
+#include "LargeTour.h"
+
+#define EPSILON     1e-7    // Smallest gain that counts as an improvement
+#define HILBERT_N   65536   // Side of the grid the Hilbert curve is laid over
+#define MAX_ROUNDS  8       // Most rounds with one piece size
+
+static int *tour;               // The tour being improved
+static int *pos;                // Position of every bag in it
+static int *owner;              // Piece every bag is in during a round
+static unsigned char *active;   // False while nothing near a bag has changed
+static unsigned char *retry;    // A move of the bag was outside its piece, look again next round
+
+double LargeTourLength(int *t)
+{
+    double length = 0.0;
+    int i;
+
+    #pragma omp parallel for reduction(+:length)
+    for (i = 1; i < nPoints; i++)
+        length += PointDistance(t[i-1], t[i]);
+    return length + PointDistance(t[nPoints-1], t[0]);
+}
+
+    // Position of (x, y) along the Hilbert curve through the grid
+static uint64_t HilbertKey(uint32_t x, uint32_t y)
+{
+    uint64_t d = 0;
+    uint32_t s, rx, ry, tmp;
+
+    for (s = HILBERT_N / 2; s > 0; s /= 2)
+    {
+        rx = (x & s) > 0;
+        ry = (y & s) > 0;
+        d += (uint64_t) s * s * ((3 * rx) ^ ry);
+            // Turn the quadrant so that the curve in it starts where it enters
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = HILBERT_N - 1 - x;
+                y = HILBERT_N - 1 - y;
+            }
+            tmp = x; x = y; y = tmp;
+        }
+    }
+    return d;
+}
+
+typedef struct {
+    uint64_t key;
+    int      bag;
+} CurveEntry;
+
+static int CompareCurve(const void *a, const void *b)
+{
+    const CurveEntry *x = (const CurveEntry*) a, *y = (const CurveEntry*) b;
+    if (x->key != y->key)
+        return x->key < y->key ? -1 : 1;
+    return x->bag - y->bag;
+}
+
+    // Visits the bags in the order of a Hilbert curve, returns the length
+double SpaceFillingTour(int *t)
+{
+    CurveEntry *curve = (CurveEntry*) malloc(nPoints * sizeof(CurveEntry));
+    double minX = points[0].x, maxX = minX, minY = points[0].y, maxY = minY, scale;
+    int i;
+
+    for (i = 1; i < nPoints; i++)
+    {
+        if (points[i].x < minX) minX = points[i].x;
+        if (points[i].x > maxX) maxX = points[i].x;
+        if (points[i].y < minY) minY = points[i].y;
+        if (points[i].y > maxY) maxY = points[i].y;
+    }
+    scale = maxX - minX > maxY - minY ? maxX - minX : maxY - minY;
+    scale = scale > 0.0 ? (HILBERT_N - 1) / scale : 0.0;
+
+    #pragma omp parallel for
+    for (i = 0; i < nPoints; i++)
+    {
+        curve[i].key = HilbertKey((uint32_t) ((points[i].x - minX) * scale),
+                                  (uint32_t) ((points[i].y - minY) * scale));
+        curve[i].bag = i;
+    }
+    qsort(curve, nPoints, sizeof(CurveEntry), CompareCurve);
+    for (i = 0; i < nPoints; i++)
+        t[i] = curve[i].bag;
+    free(curve);
+    return LargeTourLength(t);
+}
+
+typedef struct {
+    double length;
+    int    from, to;
+} Edge;
+
+static int CompareEdge(const void *a, const void *b)
+{
+    const Edge *x = (const Edge*) a, *y = (const Edge*) b;
+    if (x->length != y->length)
+        return x->length < y->length ? -1 : 1;
+    if (x->from != y->from)
+        return x->from - y->from;
+    return x->to - y->to;
+}
+
+static int Find(int *parent, int i)
+{
+    while (parent[i] != i)
+        i = parent[i] = parent[parent[i]];
+    return i;
+}
+
+/*
+ * Greedy matching: takes the candidate edges shortest first, each one that
+ * joins two bags with fewer than two edges and doesn't close a cycle. The
+ * paths this leaves are joined in the order of the Hilbert curve, each
+ * entered at whichever end the curve reaches first. Returns the length.
+ */
+double GreedyTour(int *t)
+{
+    Edge *edges = (Edge*) malloc((size_t) nPoints * nCandidates * sizeof(Edge) + 1);
+    int *parent = (int*) malloc(nPoints * sizeof(int));
+    int *adj = (int*) malloc(2 * nPoints * sizeof(int));
+    char *placed = (char*) calloc(nPoints, 1);
+    int *curve = (int*) malloc(nPoints * sizeof(int));
+    long nEdges = 0, e;
+    int i, k, n = 0;
+
+        // Every candidate pair once
+    for (i = 0; i < nPoints; i++)
+    {
+        int *cand = Candidates(i);
+        for (k = 0; k < nCandidates; k++)
+        {
+            int c = cand[k], j, mutual = 0;
+            int *back = Candidates(c);
+            for (j = 0; j < nCandidates && !mutual; j++)
+                mutual = back[j] == i;
+            if (mutual && c < i)
+                continue;
+            edges[nEdges].length = PointDistance(i, c);
+            edges[nEdges].from   = i < c ? i : c;
+            edges[nEdges].to     = i < c ? c : i;
+            nEdges++;
+        }
+        parent[i] = i;
+        adj[2*i] = adj[2*i+1] = -1;
+    }
+    qsort(edges, nEdges, sizeof(Edge), CompareEdge);
+
+    for (e = 0; e < nEdges; e++)
+    {
+        int a = edges[e].from, b = edges[e].to;
+        if (adj[2*a+1] >= 0 || adj[2*b+1] >= 0 || Find(parent, a) == Find(parent, b))
+            continue;
+        parent[Find(parent, a)] = Find(parent, b);
+        adj[2*a + (adj[2*a] >= 0)] = b;
+        adj[2*b + (adj[2*b] >= 0)] = a;
+    }
+
+        // Walk the paths, starting each at the end the curve gets to first
+    SpaceFillingTour(curve);
+    for (i = 0; i < nPoints; i++)
+    {
+        int at = curve[i], prev = -1;
+        if (placed[at] || adj[2*at+1] >= 0)
+            continue;
+        while (at >= 0)
+        {
+            int next = adj[2*at] != prev ? adj[2*at] : adj[2*at+1];
+            placed[at] = 1;
+            t[n++] = at;
+            prev = at;
+            at = next;
+        }
+    }
+
+    free(edges);
+    free(parent);
+    free(adj);
+    free(placed);
+    free(curve);
+    return LargeTourLength(t);
+}
+
+    // Reverses tour[i..j]
+static void Reverse(int i, int j)
+{
+    int tmp;
+    for (; i < j; i++, j--)
+    {
+        tmp = tour[i]; tour[i] = tour[j]; tour[j] = tmp;
+        pos[tour[i]] = i;
+        pos[tour[j]] = j;
+    }
+}
+
+static inline void Activate(int a, int b, int c, int d)
+{
+    active[a] = active[b] = active[c] = active[d] = 1;
+}
+
+/*
+ * 2-opt from bag 'a' in the piece tour[lo..hi): replaces the edge from 'a'
+ * to its successor b (or predecessor) and the matching edge of a candidate
+ * c by (a,c) and the edge between the two bags they leave, reversing the
+ * part in between. Only candidates nearer than b can give a shorter tour.
+ * Returns the gain of the move made, 0 if none.
+ */
+static double TwoOptMove(int lo, int hi, int me, int a, int *blocked)
+{
+    int *cand = Candidates(a), pa = pos[a], dir, k;
+
+    for (dir = 1; dir >= -1; dir -= 2)
+    {
+        int pb = pa + dir;
+        if (pb < lo || pb >= hi)
+        {
+            *blocked = 1;
+            continue;
+        }
+        int b = tour[pb];
+        double dab = PointDistance(a, b);
+
+        for (k = 0; k < nCandidates; k++)
+        {
+            int c = cand[k];
+            double g1 = dab - PointDistance(a, c);
+            if (g1 <= EPSILON)
+                break;
+            if (owner[c] != me)
+            {
+                *blocked = 1;
+                continue;
+            }
+            int pc = pos[c], pd = pc + dir;
+            if (pd < lo || pd >= hi)
+                *blocked = 1;
+            if (pd < lo || pd >= hi || pd == pa || c == b)
+                continue;
+            int d = tour[pd];
+            double gain = g1 + PointDistance(c, d) - PointDistance(b, d);
+            if (gain <= EPSILON)
+                continue;
+
+            if (dir == 1)
+            {
+                if (pc > pa)
+                    Reverse(pa + 1, pc);
+                else
+                    Reverse(pc + 1, pa);
+            }
+            else
+            {
+                if (pc > pa)
+                    Reverse(pa, pc - 1);
+                else
+                    Reverse(pc, pa - 1);
+            }
+            Activate(a, b, c, d);
+            return gain;
+        }
+    }
+    return 0.0;
+}
+
+    // Moves tour[i..i+len) to between tour[j] and tour[j+1], turned around if 'rev'
+static void MoveSegment(int i, int len, int j, int rev)
+{
+    int seg[3], k, from, to;
+
+    for (k = 0; k < len; k++)
+        seg[k] = tour[i + k];
+    if (j > i)
+    {
+        memmove(tour + i, tour + i + len, (j - i - len + 1) * sizeof(int));
+        from = i;
+        to = j;
+    }
+    else
+    {
+        memmove(tour + j + 1 + len, tour + j + 1, (i - j - 1) * sizeof(int));
+        from = j + 1;
+        to = i + len - 1;
+    }
+    for (k = 0; k < len; k++)
+        tour[(j > i ? j - len + 1 : j + 1) + k] = rev ? seg[len - 1 - k] : seg[k];
+    for (k = from; k <= to; k++)
+        pos[tour[k]] = k;
+}
+
+/*
+ * Or-opt from bag 'a': moves the 1, 2 or 3 bags from 'a' on to between a
+ * candidate of either end of the segment and one of that candidate's
+ * neighbours, in the direction that is shorter. Returns the gain, 0 if none.
+ */
+static double OrOptMove(int lo, int hi, int me, int a, int *blocked)
+{
+    int i = pos[a], len, end, k, side;
+
+    for (len = 1; len <= 3; len++)
+    {
+        if (i - 1 < lo || i + len >= hi)
+        {
+            *blocked = 1;
+            break;
+        }
+        int s0 = a, sL = tour[i + len - 1];
+        int p = tour[i - 1], q = tour[i + len];
+        double removed = PointDistance(p, s0) + PointDistance(sL, q) - PointDistance(p, q);
+        if (removed <= EPSILON)
+            continue;
+
+        for (end = 0; end < (len > 1 ? 2 : 1); end++)
+        {
+            int *cand = Candidates(end == 0 ? s0 : sL);
+            for (k = 0; k < nCandidates; k++)
+            {
+                int c = cand[k];
+                if (PointDistance(end == 0 ? s0 : sL, c) >= removed)
+                    break;
+                if (owner[c] != me)
+                {
+                    *blocked = 1;
+                    continue;
+                }
+                int pc = pos[c];
+                if (pc >= i && pc < i + len)
+                    continue;
+
+                    // The edges on either side of c
+                for (side = -1; side <= 0; side++)
+                {
+                    int j = pc + side;
+                    if (j < lo || j + 1 >= hi)
+                        *blocked = 1;
+                    if (j < lo || j + 1 >= hi || (j >= i - 1 && j <= i + len - 1))
+                        continue;
+                    int x = tour[j], y = tour[j+1];
+                    double dxy = PointDistance(x, y);
+                    double add = PointDistance(x, s0) + PointDistance(sL, y) - dxy;
+                    double addRev = PointDistance(x, sL) + PointDistance(s0, y) - dxy;
+                    int rev = addRev < add;
+                    double gain = removed - (rev ? addRev : add);
+                    if (gain <= EPSILON)
+                        continue;
+
+                    MoveSegment(i, len, j, rev);
+                    Activate(p, q, x, y);
+                    active[s0] = active[sL] = 1;
+                    return gain;
+                }
+            }
+        }
+    }
+    return 0.0;
+}
+
+    // 2-opt and Or-opt in tour[lo..hi) until no bag in it has a move left;
+    // 'me' is the piece, only its bags are moved. Bags that may have a move
+    // that leaves the piece are marked to retry. Returns the total gain.
+static double ImprovePiece(int lo, int hi, int me)
+{
+    double gain = 0.0, g;
+    int i, again = 1, blocked;
+
+    while (again)
+    {
+        again = 0;
+        for (i = lo; i < hi; i++)
+        {
+            int a = tour[i];
+            if (!active[a])
+                continue;
+            active[a] = 0;
+            blocked = 0;
+            while ((g = TwoOptMove(lo, hi, me, a, &blocked)) > 0.0 ||
+                   (g = OrOptMove(lo, hi, me, a, &blocked)) > 0.0)
+            {
+                gain += g;
+                again = 1;
+                blocked = 0;
+            }
+            if (blocked)
+                retry[a] = 1;
+        }
+    }
+    return gain;
+}
+
+    // Rotates t left by 'shift' positions, using 'buf'
+static void Rotate(int *t, int *buf, int shift)
+{
+    memcpy(buf, t + shift, (nPoints - shift) * sizeof(int));
+    memcpy(buf + nPoints - shift, t, shift * sizeof(int));
+    memcpy(t, buf, nPoints * sizeof(int));
+}
+
+/*
+ * Improves the tour 't' with 2-opt and Or-opt over the candidate lists,
+ * in pieces of 'piece' positions to start with (see LargeTour.h), on the
+ * OpenMP threads. Returns the new length.
+ */
+double ImproveTour(int *t, int piece)
+{
+    int *buf, size, round, nPieces, p, i;
+    double gain;
+
+    if (nPoints < 8 || nCandidates == 0)
+        return LargeTourLength(t);
+
+    tour   = t;
+    pos    = (int*) malloc(nPoints * sizeof(int));
+    owner  = (int*) malloc(nPoints * sizeof(int));
+    buf    = (int*) malloc(nPoints * sizeof(int));
+    active = (unsigned char*) malloc(nPoints);
+    retry  = (unsigned char*) malloc(nPoints);
+    memset(retry, 1, nPoints);
+    size   = piece < LARGE_MIN_PIECE ? LARGE_MIN_PIECE : piece;
+    if (size > nPoints)
+        size = nPoints;
+
+    for (;;)
+    {
+        nPieces = (nPoints + size - 1) / size;
+        for (round = 0; round < MAX_ROUNDS; round++)
+        {
+                // Shift the cuts, so that the bags next to them can move this time
+            if (round > 0)
+                Rotate(tour, buf, size / 2);
+            for (i = 0; i < nPoints; i++)
+            {
+                pos[tour[i]]   = i;
+                owner[tour[i]] = i / size;
+                active[i]      = retry[i];
+                retry[i]       = 0;
+            }
+
+            gain = 0.0;
+            #pragma omp parallel for schedule(dynamic, 1) reduction(+:gain)
+            for (p = 0; p < nPieces; p++)
+            {
+                int lo = p * size, hi = lo + size < nPoints ? lo + size : nPoints;
+                gain += ImprovePiece(lo, hi, p);
+            }
+            if (gain == 0.0 && round > 0)
+                break;
+        }
+        if (size == nPoints)
+            break;
+        size = size < nPoints / 2 ? 2 * size : nPoints;
+    }
+
+    free(pos);
+    free(owner);
+    free(buf);
+    free(active);
+    free(retry);
+    return LargeTourLength(t);
+}
+
+    // Rotates the tour to start at bag 0 and turns it around if needed, so
+    // that it leaves bag 0 for the nearer of its two neighbours
+void RotateLargeTour(int *t)
+{
+    int *buf = (int*) malloc(nPoints * sizeof(int));
+    int i, at = 0, tmp;
+
+    while (t[at] != 0)
+        at++;
+    if (at > 0)
+        Rotate(t, buf, at);
+    free(buf);
+    if (nPoints > 2 && (PointDistance(0, t[1]) > PointDistance(0, t[nPoints-1]) ||
+                        (PointDistance(0, t[1]) == PointDistance(0, t[nPoints-1]) && t[1] > t[nPoints-1])))
+        for (i = 1; i < nPoints - i; i++)
+        {
+            tmp = t[i]; t[i] = t[nPoints-i]; t[nPoints-i] = tmp;
+        }
+}
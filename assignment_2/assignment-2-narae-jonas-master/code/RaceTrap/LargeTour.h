@@ -0,0 +1,37 @@
+/*
+ * Heuristic tours for large RaceTrap instances (LargeRoute.h).
+ *
+ * The first tour visits the bags in the order of a Hilbert curve through
+ * the plane, which keeps bags that are near each other near each other in
+ * the tour. ImproveTour() then runs 2-opt and Or-opt, like Heuristic.c,
+ * but only tries moves that join a bag to one of its candidates and only
+ * looks at bags whose neighbourhood changed since they were last looked at
+ * ("don't look" bits), so a pass costs O(n k) instead of O(n^2).
+ *
+ * The tour is an array, so a 2-opt move reverses part of it. To keep that
+ * cheap and to use all threads, the tour is cut into pieces of consecutive
+ * positions that are improved independently, one thread each, by moves that
+ * stay inside the piece and leave its first and last bag in place. The cuts
+ * are shifted by half a piece each round, and once no piece improves the
+ * pieces are doubled, until a single piece covers the whole tour.
+ */
+
+#ifndef LARGETOUR_H
+#define LARGETOUR_H
+
+#include "LargeRoute.h"
+
+#define LARGE_PIECE 1024    // Default number of positions in a piece of the first rounds
+#define LARGE_MIN_PIECE 8   // Fewest positions in a piece
+
+double LargeTourLength(int *tour);
+
+double SpaceFillingTour(int *tour);
+
+double GreedyTour(int *tour);
+
+double ImproveTour(int *tour, int piece);
+
+void RotateLargeTour(int *tour);
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ * Brute-force solver for the last few bags, see LeafSolver.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "Route.h"
+#include "LeafSolver.h"
+
+int leafBags = 0;           // Bags left when the search hands over, 0 to never
+
+typedef struct {
+    int            nOrders; // r! orders of r bags
+    unsigned char *edges;   // (r+1) x nOrders matrix indices, edge by edge
+    unsigned char *first;   // nOrders x r, the orders themselves
+} OrderTable;
+
+static OrderTable tables[LEAF_MAX + 1];
+static int built = 0;       // Largest r with a table
+
+    // Steps 'order' of 'r' items on to the next in lexicographic order, false after the last
+static int NextOrder(unsigned char *order, int r)
+{
+    int i = r - 2, j;
+    unsigned char tmp;
+
+    while (i >= 0 && order[i] > order[i+1])
+        i--;
+    if (i < 0)
+        return 0;
+    for (j = r - 1; order[j] < order[i]; j--)
+        ;
+    tmp = order[i]; order[i] = order[j]; order[j] = tmp;
+    for (i++, j = r - 1; i < j; i++, j--)
+    {
+        tmp = order[i]; order[i] = order[j]; order[j] = tmp;
+    }
+    return 1;
+}
+
+/*
+ * Builds the order tables for 2..maxBags bags (at most LEAF_MAX). Row r of
+ * the distance matrix is the last placed bag going out and column r is the
+ * way home to bag 0, so an order o takes the edges (r,o0), (o0,o1), ...,
+ * (o[r-1],r). Not thread safe, called before the search starts.
+ */
+void InitLeafTables(int maxBags)
+{
+    unsigned char order[LEAF_MAX];
+    int r, n, k, s;
+
+    if (maxBags > LEAF_MAX)
+        maxBags = LEAF_MAX;
+    for (r = built + 1; r <= maxBags; r++)
+    {
+        OrderTable *t = &tables[r];
+        for (t->nOrders = 1, k = 2; k <= r; k++)
+            t->nOrders *= k;
+        t->edges = (unsigned char*) malloc((r + 1) * t->nOrders);
+        t->first = (unsigned char*) malloc(r * t->nOrders);
+
+        for (k = 0; k < r; k++)
+            order[k] = (unsigned char) k;
+        n = 0;
+        do
+        {
+            memcpy(t->first + n * r, order, r);
+            t->edges[n] = (unsigned char) (r * LEAF_STRIDE + order[0]);
+            for (s = 1; s < r; s++)
+                t->edges[s * t->nOrders + n] = (unsigned char) (order[s-1] * LEAF_STRIDE + order[s]);
+            t->edges[r * t->nOrders + n] = (unsigned char) (order[r-1] * LEAF_STRIDE + r);
+            n++;
+        }
+        while (NextOrder(order, r));
+    }
+    if (maxBags > built)
+        built = maxBags;
+}
+
+/*
+ * Completes path[0..nPlaced-1], which has length 'length', with the best
+ * order of the r = nBags-nPlaced bags in path[nPlaced..] that ends in a bag
+ * of rank[] above 'minRank'. Puts it in path[nPlaced..] and returns its
+ * length including the way home, or INFINITY (path unchanged) if no order
+ * may end the tour. Equal lengths go to the lexicographically first path.
+ */
+double SolveLeaf(unsigned char *path, int nPlaced, double length,
+                 const unsigned char *rank, int minRank)
+{
+    double matrix[LEAF_STRIDE * LEAF_STRIDE];
+    double lengths[LEAF_BLOCK];
+    unsigned char bags[LEAF_MAX];
+    int r = nBags - nPlaced, last = path[nPlaced-1], a, b, s, p, start;
+    double best = INFINITY;
+    long bestOrder = -1;
+    OrderTable *t = &tables[r];
+
+        // The remaining bags in increasing order, so that the first of two
+        // equal orders in the table is also the first path
+    memcpy(bags, path + nPlaced, r);
+    for (a = 1; a < r; a++)
+        for (b = a; b > 0 && bags[b-1] > bags[b]; b--)
+        {
+            unsigned char tmp = bags[b]; bags[b] = bags[b-1]; bags[b-1] = tmp;
+        }
+
+    for (a = 0; a < r; a++)
+    {
+        for (b = 0; b < r; b++)
+            matrix[a * LEAF_STRIDE + b] = Distance(bags[a], bags[b]);
+        matrix[r * LEAF_STRIDE + a] = Distance(last, bags[a]);
+            // Only the direction of the tour that the search looks at may end here
+        matrix[a * LEAF_STRIDE + r] = rank[bags[a]] > minRank ? Distance(bags[a], 0) : INFINITY;
+    }
+
+    for (start = 0; start < t->nOrders; start += LEAF_BLOCK)
+    {
+        int n = t->nOrders - start < LEAF_BLOCK ? t->nOrders - start : LEAF_BLOCK;
+        double blockBest = INFINITY;
+
+        for (p = 0; p < n; p++)
+            lengths[p] = length;
+        for (s = 0; s <= r; s++)
+        {
+            const unsigned char *edge = t->edges + s * t->nOrders + start;
+            #pragma omp simd
+            for (p = 0; p < n; p++)
+                lengths[p] += matrix[edge[p]];
+        }
+
+        #pragma omp simd reduction(min:blockBest)
+        for (p = 0; p < n; p++)
+            blockBest = lengths[p] < blockBest ? lengths[p] : blockBest;
+        if (blockBest < best)
+        {
+            for (p = 0; lengths[p] != blockBest; p++)
+                ;
+            best = blockBest;
+            bestOrder = start + p;
+        }
+    }
+
+    if (bestOrder < 0)
+        return INFINITY;
+    for (a = 0; a < r; a++)
+        path[nPlaced + a] = bags[t->first[bestOrder * r + a]];
+    return best;
+}
@@ -0,0 +1,34 @@
+/*
+ * Brute-force solver for the last few bags of a RaceTrap search.
+ *
+ * Near the leaves the depth-first search spends more on its bookkeeping
+ * (frames, swaps, bound checks and hard to predict branches) than on the
+ * distances it adds up. With 'leafBags' set, SearchFrom() stops descending
+ * once at most that many bags are left and hands the rest to SolveLeaf(),
+ * which tries every order of them.
+ *
+ * The orders of r bags are precomputed once, in lexicographic order, as
+ * tables of the r+1 edges each order takes, indices into a small distance
+ * matrix of the remaining bags. The lengths of a block of orders are then
+ * summed edge by edge across the block, a loop of gathers that the compiler
+ * vectorizes, followed by a min-reduction. Every order is summed in the
+ * same order as the search adds its edges, so the lengths are exactly those
+ * the search would find, and equal lengths go to the first order, which
+ * is the one the search would keep.
+ */
+
+#ifndef LEAFSOLVER_H
+#define LEAFSOLVER_H
+
+#define LEAF_MAX     8      // Most bags the tables are built for (8! orders)
+#define LEAF_STRIDE  (LEAF_MAX + 1)
+#define LEAF_BLOCK   256    // Orders summed together
+
+extern int leafBags;        // Bags left when the search hands over, 0 to never
+
+void InitLeafTables(int maxBags);
+
+double SolveLeaf(unsigned char *path, int nPlaced, double length,
+                 const unsigned char *rank, int minRank);
+
+#endif
@@ -0,0 +1,451 @@
+/*
+ * Bitmask search engine for RaceTrap, see MaskSearch.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "Route.h"
+#include "Search.h"
+#include "Bound.h"
+#include "TransTable.h"
+#include "Progress.h"
+#include "Timer.h"
+#include "SearchStats.h"
+#include "MaskSearch.h"
+
+typedef struct {
+    MaskNode      node;
+    int           next;     // Next entry of child to try
+    int           count;    // Entries in child
+    unsigned char child[MASK_MAX_BAGS];  // Unplaced bags, nearest to node.last first
+} MaskFrame;
+
+typedef struct {
+    MaskFrame       *frames;  // Depth-first stack, frame d has d bags placed
+    double          *penalty; // Held-Karp penalties, nBags per depth (BOUND_ONETREE)
+    RouteDefinition *best;    // Best complete route this thread found
+    unsigned char   *prefix;  // Path of the running task, its first 'base' bags
+    int              base;
+    ProgressRing    *progress;
+    long             nodes;
+    int              poll;
+    double           openBound; // Lowest bound of the work it abandoned at the deadline
+#ifdef SEARCH_STATS
+    SearchStats     *stats;   // Counters of this thread (SearchStats.h)
+#endif
+} MaskThread;
+
+#ifdef SEARCH_STATS
+    // Counts a child of 'depth' pruned for 'reason' and gives 'res'
+#define PRUNED(t, depth, reason, res) (Pruned((t)->stats, depth, reason), res)
+#else
+#define PRUNED(t, depth, reason, res) (res)
+#endif
+
+static uint64_t allBags;    // Bit b for every bag b
+static unsigned char homeRank[MASK_MAX_BAGS];  // Place of every bag in Neighbours(0)
+static uint64_t farther[MASK_MAX_BAGS];        // Bags further from bag 0 than rank r
+
+static inline uint64_t Bit(int b)
+{
+    return (uint64_t) 1 << b;
+}
+
+static MaskThread *Alloc_MaskThread()
+{
+    MaskThread *t = (MaskThread*) calloc(1, sizeof(MaskThread));
+
+    t->frames  = (MaskFrame*) malloc((nBags + 1) * sizeof(MaskFrame));
+    if (boundMode == BOUND_ONETREE)
+        t->penalty = (double*) calloc((nBags + 1) * nBags, sizeof(double));
+    t->best = Alloc_RouteDefinition();
+    t->best->length = maxRouteLen;
+    t->poll = POLL_INTERVAL;
+    t->openBound = maxRouteLen;
+    STATS(t->stats = Alloc_SearchStats());
+    return t;
+}
+
+static void Free_MaskThread(MaskThread *t)
+{
+    free(t->frames);
+    free(t->penalty);
+    free(t->best);
+    STATS(free(t->stats));
+    free(t);
+}
+
+    // Fills frame 'depth' with the unplaced bags, nearest to its last bag
+    // first, and equally near ones by number
+static void OpenMaskFrame(MaskThread *t, int depth)
+{
+    MaskFrame *f = &t->frames[depth];
+    uint64_t rest = allBags & ~f->node.mask;
+    double dist[MASK_MAX_BAGS], d;
+    int n = 0, k, b;
+
+    while (rest)
+    {
+        b = __builtin_ctzll(rest);
+        rest &= rest - 1;
+        d = Distance(f->node.last, b);
+        for (k = n; k > 0 && dist[k-1] > d; k--)
+        {
+            dist[k] = dist[k-1];
+            f->child[k] = f->child[k-1];
+        }
+        dist[k] = d;
+        f->child[k] = (unsigned char) b;
+        n++;
+    }
+    f->next  = 0;
+    f->count = n;
+    if (boundMode == BOUND_ONETREE && depth == t->base)
+        memcpy(t->penalty + depth * nBags, rootPenalty, nBags * sizeof(double));
+}
+
+    // Puts the path together from the task's prefix, the frames base+1..depth
+    // and 'last', and keeps it if it beats the best route of the thread
+static void RecordMask(MaskThread *t, int depth, int last, double length)
+{
+    unsigned char path[nBags];
+    int d;
+
+    memcpy(path, t->prefix, t->base);
+    for (d = t->base + 1; d <= depth; d++)
+        path[d-1] = t->frames[d].node.last;
+    path[depth] = (unsigned char) last;
+    if (!BetterRoute(length, path, t->best))
+        return;
+
+    t->best->length  = length;
+    t->best->nPlaced = nBags;
+    memcpy(t->best->path, path, nBags);
+    if (UpdateBest(length))
+    {
+        STATS(NoteImprovement(t->stats, length));
+        if (t->progress != NULL)
+            PushProgress(t->progress, length, path);
+    }
+}
+
+/*
+ * Looks at bag 'b' as the next bag after 'parent', which has 'depth' bags
+ * placed. Returns CHILD_OPEN with the child in 'child' if its subtree has
+ * to be searched, as TryChild() in Search.h does.
+ */
+static int TryMaskChild(MaskThread *t, int depth, MaskNode *parent, int b, MaskNode *child)
+{
+    double newLength = parent->length + Distance(parent->last, b);
+    uint64_t newMask, rest, ends;
+    unsigned char *list;
+    double newBound;
+    int second, k;
+
+        // The children are nearest first, so the ones after this are too long as well
+    if (newLength > ReadBest())
+        return CHILD_FAR;
+    newMask = parent->mask | Bit(b);
+    rest    = allBags & ~newMask;
+    second  = depth == 1 ? b : parent->second;
+
+    if (rest == 0)
+    {
+        t->nodes++;
+        STATS(t->stats->expanded[depth+1]++);
+        if (depth >= 2 && homeRank[b] < homeRank[second])
+            return CHILD_DONE;
+        newLength += Distance(b, 0);
+        if (newLength <= ReadBest())
+            RecordMask(t, depth, b, newLength);
+        return CHILD_DONE;
+    }
+        // Every tour is also found backwards, so only the direction that
+        // leaves bag 0 for a nearer bag than it comes home from is searched:
+        // one of the bags further from bag 0 than the second has to be left
+    ends = rest & farther[homeRank[second]];
+    if (ends == 0)
+        return CHILD_DONE;
+    t->nodes++;
+    STATS(t->stats->expanded[depth+1]++);
+
+        // The way back home is at least as long as from the nearest of them
+    list = Neighbours(0);
+    for (k = homeRank[second] + 1; !(ends & Bit(list[k])); k++)
+        ;
+    if (newLength + Distance(0, list[k]) > ReadBest())
+        return PRUNED(t, depth + 1, PRUNE_HOME, CHILD_DONE);
+    if (depth + 1 >= TT_MIN_PLACED && depth + 1 <= ttDepth &&
+        Dominated(newMask, b, second, depth + 1, newLength))
+        return PRUNED(t, depth + 1, PRUNE_DOMINATED, CHILD_DONE);
+
+    switch (boundMode)
+    {
+    case BOUND_MINEDGE:
+        newBound = MinEdgeChild(parent->bound, depth, parent->last, b);
+        break;
+
+    case BOUND_ONETREE:
+        {
+            unsigned char nodes[MASK_MAX_BAGS];
+            uint64_t left = allBags & ~parent->mask;
+            int m = 0, skip = -1;
+            double *pi = t->penalty + (depth + 1) * nBags;
+
+            while (left)
+            {
+                int c = __builtin_ctzll(left);
+                left &= left - 1;
+                if (c == b)
+                    skip = m;
+                nodes[m++] = (unsigned char) c;
+            }
+                // Warm start from the penalties of the parent
+            memcpy(pi, t->penalty + depth * nBags, nBags * sizeof(double));
+            newBound = OneTreeBound(0, b, nodes, m, skip, pi, HK_NODE_ITERS, ReadBest() - newLength);
+        }
+        break;
+
+    default:
+        newBound = 0.0;
+    }
+    if (newLength + newBound > ReadBest())
+        return PRUNED(t, depth + 1, PRUNE_BOUND, CHILD_DONE);
+
+    child->mask   = newMask;
+    child->length = newLength;
+    child->bound  = newBound;
+    child->last   = (unsigned char) b;
+    child->second = (unsigned char) second;
+    child->prefix = -1;
+    return CHILD_OPEN;
+}
+
+    // Depth-first search of every route that starts with 'task', which has
+    // 'base' bags placed, the path in t->prefix
+static void SearchMask(MaskThread *t, MaskNode *task, int base)
+{
+    MaskFrame *frames = t->frames;
+    MaskFrame *f;
+    int depth = base, b, d, res;
+
+    t->base = base;
+    frames[base].node = *task;
+    OpenMaskFrame(t, base);
+
+    for (;;)
+    {
+        f = &frames[depth];
+
+        if (f->next >= f->count)
+        {
+            if (depth == base)
+                break;
+            depth--;
+            continue;
+        }
+
+        if (--t->poll == 0)
+        {
+            t->poll = POLL_INTERVAL;
+            if (SearchExpired())
+            {
+                    // Out of time: leave the untried children of every frame
+                for (d = base; d <= depth; d++)
+                    if (frames[d].next < frames[d].count)
+                    {
+                        MaskNode *n = &frames[d].node;
+                        if (n->length + n->bound < t->openBound)
+                            t->openBound = n->length + n->bound;
+                        frames[d].next = frames[d].count;
+                    }
+            }
+            continue;
+        }
+
+        b = f->child[f->next++];
+        res = TryMaskChild(t, depth, &f->node, b, &frames[depth+1].node);
+        if (res == CHILD_FAR)
+            f->next = f->count;
+        if (res != CHILD_OPEN)
+            continue;
+        depth++;
+        OpenMaskFrame(t, depth);
+    }
+}
+
+/*
+ * Expands the nodes from bag 0 level by level with the thread 't' until
+ * there are at least MASK_TASKS per thread or MASK_MIN_REST bags are left,
+ * and returns them in '*tasks' in the order the depth-first search would
+ * reach them, so that a cold search finds short routes early. Their paths
+ * are in '*prefixes', '*base' bags each. Returns the number of tasks.
+ */
+static long MakeTasks(MaskThread *t, int nThreads, double rootBound, MaskNode **tasks,
+                      unsigned char **prefixes, int *base)
+{
+    MaskNode *level = (MaskNode*) malloc(sizeof(MaskNode));
+    unsigned char *paths = (unsigned char*) malloc(1);
+    long n = 1, i;
+    int depth = 1;
+
+    level[0].mask   = 1;
+    level[0].length = 0.0;
+    level[0].bound  = rootBound;
+    level[0].last   = 0;
+    level[0].second = 0;
+    level[0].prefix = 0;
+    paths[0] = 0;
+
+    while (n > 0 && n < (long) MASK_TASKS * nThreads && nBags - depth > MASK_MIN_REST)
+    {
+        long max = n * (nBags - depth), m = 0;
+        MaskNode *next = (MaskNode*) malloc(max * sizeof(MaskNode));
+        unsigned char *nextPaths = (unsigned char*) malloc(max * (depth + 1));
+
+        for (i = 0; i < n; i++)
+        {
+            MaskFrame *f = &t->frames[depth];
+            t->prefix = paths + level[i].prefix * depth;
+            t->base   = depth;
+            f->node   = level[i];
+            OpenMaskFrame(t, depth);
+            while (f->next < f->count)
+            {
+                int b = f->child[f->next++];
+                int res = TryMaskChild(t, depth, &f->node, b, &next[m]);
+                if (res == CHILD_FAR)
+                    break;
+                if (res != CHILD_OPEN)
+                    continue;
+                memcpy(nextPaths + m * (depth + 1), t->prefix, depth);
+                nextPaths[m * (depth + 1) + depth] = (unsigned char) b;
+                next[m].prefix = (int32_t) m;
+                m++;
+            }
+        }
+        free(level);
+        free(paths);
+        level = next;
+        paths = nextPaths;
+        n = m;
+        depth++;
+    }
+
+    *tasks    = level;
+    *prefixes = paths;
+    *base     = depth;
+    return n;
+}
+
+/*
+ * Searches for the shortest route with the bitmask engine on
+ * omp_get_max_threads() threads and returns it. 'seed' is as for
+ * ShortestRoute(). Falls back to ShortestRoutePar() for more than
+ * MASK_MAX_BAGS bags.
+ */
+RouteDefinition *MaskRoute(RouteDefinition *seed)
+{
+    int nThreads = omp_get_max_threads();
+    MaskThread **threads;
+    RouteDefinition *res;
+    MaskNode *tasks;
+    unsigned char *prefixes;
+    double rootBound;
+    long nTasks, i;
+    int t, base;
+
+    if (nBags > MASK_MAX_BAGS)
+    {
+        printf("The bitmask search needs at most %d bags, searching with paths\n", MASK_MAX_BAGS);
+        return ShortestRoutePar(seed);
+    }
+
+    res = Alloc_RouteDefinition();
+    res->nPlaced = nBags;
+    if (nBags == 1)
+    {
+        res->path[0] = 0;
+        res->length  = 0.0;
+        nodesExpanded = 0;
+        lowerBound = 0.0;
+        return res;
+    }
+
+    allBags = nBags == 64 ? ~(uint64_t) 0 : Bit(nBags) - 1;
+    for (t = nBags - 2; t >= 0; t--)
+    {
+        homeRank[Neighbours(0)[t]] = (unsigned char) t;
+        farther[t] = t == nBags - 2 ? 0 : farther[t+1] | Bit(Neighbours(0)[t+1]);
+    }
+    threads = (MaskThread**) malloc(nThreads * sizeof(MaskThread*));
+    for (t = 0; t < nThreads; t++)
+    {
+        threads[t] = Alloc_MaskThread();
+        threads[t]->progress = Progress_Ring(t);
+    }
+    if (seed != NULL)
+    {
+        memcpy(threads[0]->best, seed, sizeof(RouteDefinition) + nBags);
+        UpdateBest(seed->length);
+    }
+    Init_TransTable(TT_MEGABYTES);
+    rootBound = RootBound();
+
+    STATS(statsStart = omp_get_wtime());
+    nTasks = MakeTasks(threads[0], nThreads, rootBound, &tasks, &prefixes, &base);
+
+    #pragma omp parallel num_threads(nThreads)
+    {
+        MaskThread *me = threads[omp_get_thread_num()];
+
+        #pragma omp for schedule(dynamic, 1)
+        for (i = 0; i < nTasks; i++)
+        {
+            MaskNode *task = &tasks[i];
+
+            if (SearchExpired())
+            {
+                if (task->length + task->bound < me->openBound)
+                    me->openBound = task->length + task->bound;
+                continue;
+            }
+            if (task->length + task->bound > ReadBest())
+                continue;
+            me->prefix = prefixes + task->prefix * base;
+            STATS(double t0 = omp_get_wtime());
+            Timer_Start("/subproblem");
+            SearchMask(me, task, base);
+            Timer_Stop();
+            STATS(me->stats->searchTime += omp_get_wtime() - t0);
+            STATS(me->stats->searched++);
+            STATS(me->stats->popped++);
+        }
+    }
+
+    STATS(SearchStats *stats[nThreads]);
+    STATS(for (t = 0; t < nThreads; t++) stats[t] = threads[t]->stats);
+    STATS(Collect_SearchStats(stats, nThreads, omp_get_wtime() - statsStart));
+
+    res->length = maxRouteLen;
+    nodesExpanded = 0;
+    lowerBound = maxRouteLen;
+    for (t = 0; t < nThreads; t++)
+    {
+        nodesExpanded += threads[t]->nodes;
+        if (threads[t]->openBound < lowerBound)
+            lowerBound = threads[t]->openBound;
+        if (BetterRoute(threads[t]->best->length, threads[t]->best->path, res))
+            memcpy(res, threads[t]->best, sizeof(RouteDefinition) + nBags);
+        Free_MaskThread(threads[t]);
+    }
+    if (res->length < lowerBound)
+        lowerBound = res->length;
+    free(threads);
+    free(tasks);
+    free(prefixes);
+    Free_TransTable();
+    return res;
+}
@@ -0,0 +1,47 @@
+/*
+ * Bitmask search engine for RaceTrap instances of up to 64 bags.
+ *
+ * A node of the search is the set of placed bags as a 64 bit mask, the last
+ * bag, the bag placed after bag 0, the length and the bound: 32 bytes, no
+ * path. The unplaced bags are ~mask, walked with count-trailing-zeros, so
+ * nothing scans a path for them. A frame of the depth-first stack is the
+ * node and its unplaced bags in order of distance from the last one, about
+ * two cache lines. The path of a route is only put together when it beats
+ * the best one, from the task's prefix and the last bags of the frames.
+ *
+ * Of the two directions of a tour only the one that comes home from a bag
+ * further from bag 0 than the one it left bag 0 for is searched, as in
+ * Search.h: a child is dropped when none of those bags is left to end the
+ * tour with, one mask test. The way home from the nearest of them bounds
+ * the rest. The bounds (Bound.h) and the dominance table (TransTable.h)
+ * are the ones of the search in Search.h.
+ *
+ * Tasks are made by expanding the nodes level by level until there are
+ * MASK_TASKS per thread, which costs a node and its prefix apiece, and the
+ * threads take them nearest first, as the depth-first search would, with an
+ * OpenMP dynamic schedule. A task whose bound is longer than the best route
+ * by the time it is taken is dropped without a node.
+ */
+
+#ifndef MASKSEARCH_H
+#define MASKSEARCH_H
+
+#include <stdint.h>
+#include "Route.h"
+
+#define MASK_MAX_BAGS 64    // The placed bags are a 64 bit mask
+#define MASK_TASKS    64    // Tasks to make per thread
+#define MASK_MIN_REST 6     // Fewest unplaced bags of a task
+
+typedef struct {
+    uint64_t      mask;     // Bags placed, bit b for bag b
+    double        length;   // Length of the partial route
+    double        bound;    // Lower bound for the rest of the tour
+    int32_t       prefix;   // Of a task, the place of its path in the prefix store
+    unsigned char last;     // Last bag placed
+    unsigned char second;   // Bag placed after bag 0
+} MaskNode;
+
+RouteDefinition *MaskRoute(RouteDefinition *seed);
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * Portfolio of heuristic and exact search for RaceTrap, see Portfolio.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <omp.h>
+#include "Route.h"
+#include "Search.h"
+#include "Heuristic.h"
+#include "Progress.h"
+#include "MaskSearch.h"
+#include "Portfolio.h"
+
+#define EPSILON 1e-9
+
+static int    nExact;           // Threads of the exact search, rings 0..nExact-1
+static int    stopHeuristics = 0;
+static double rootBound;        // Proven lower bound before the search starts
+static double proofTime;        // ProgressTime() when the exact search was over
+static RouteDefinition *heuristicBest;
+static pthread_mutex_t heuristicLock = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct {
+    pthread_t thread;
+    int       ring;
+    unsigned  seed;
+} HeuristicThread;
+
+    // Double-bridge kick: cuts the tour in four parts A B C D and makes it A C B D
+static void DoubleBridge(unsigned char *tour, unsigned *seed)
+{
+    unsigned char tmp[nBags];
+    int a = 1 + rand_r(seed) % (nBags - 3);
+    int b = a + 1 + rand_r(seed) % (nBags - a - 2);
+    int c = b + 1 + rand_r(seed) % (nBags - b - 1);
+
+    memcpy(tmp, tour, a);
+    memcpy(tmp + a, tour + b, c - b);
+    memcpy(tmp + a + c - b, tour + a, b - a);
+    memcpy(tour, tmp, c);
+}
+
+    // Publishes 'tour' of 'length' if it beats the incumbent
+static void Publish(unsigned char *tour, double length, ProgressRing *ring)
+{
+    unsigned char route[nBags];
+
+    memcpy(route, tour, nBags);
+    RotateToStart(route);
+    if (!UpdateBest(length))
+        return;
+    if (ring != NULL)
+        PushProgress(ring, length, route);
+    pthread_mutex_lock(&heuristicLock);
+    if (BetterRoute(length, route, heuristicBest))
+    {
+        heuristicBest->length = length;
+        memcpy(heuristicBest->path, route, nBags);
+    }
+    pthread_mutex_unlock(&heuristicLock);
+}
+
+    // True when the heuristic threads should stop: the search is over, or
+    // some thread, exact or heuristic, found a route as short as the bound
+    // of the root, and nothing can be shorter than that
+static int HeuristicsDone()
+{
+    if (ReadBest() <= rootBound + EPSILON)
+        __atomic_store_n(&stopHeuristics, 1, __ATOMIC_RELAXED);
+    return __atomic_load_n(&stopHeuristics, __ATOMIC_RELAXED);
+}
+
+static void *Heuristic(void *arg)
+{
+    HeuristicThread *me = (HeuristicThread*) arg;
+    ProgressRing *ring = Progress_Ring(me->ring);
+    unsigned char best[nBags], tour[nBags];
+    double bestLength, length;
+    int kicks;
+
+    while (!HeuristicsDone())
+    {
+        NearestNeighbour(rand_r(&me->seed) % nBags, best);
+        bestLength = LocalSearch(best);
+        Publish(best, bestLength, ring);
+
+        for (kicks = 0; kicks < PF_KICKS && nBags >= 8 && !HeuristicsDone(); kicks++)
+        {
+            memcpy(tour, best, nBags);
+            DoubleBridge(tour, &me->seed);
+            length = LocalSearch(tour);
+            if (length < bestLength - EPSILON)
+            {
+                memcpy(best, tour, nBags);
+                bestLength = length;
+                kicks = 0;
+                Publish(best, bestLength, ring);
+            }
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Runs 'nHeuristic' heuristic threads next to the exact search on the rest
+ * of the omp_get_max_threads() threads (at least one) and returns the best
+ * route. The exact search is MaskRoute() if 'useMask', else
+ * ShortestRoutePar(). Expects Start_Progress() with a ring for every thread.
+ */
+RouteDefinition *PortfolioRoute(int nHeuristic, int useMask)
+{
+    int nThreads = omp_get_max_threads();
+    HeuristicThread *threads;
+    RouteDefinition *res;
+    int t;
+
+    if (nHeuristic > nThreads - 1)
+        nHeuristic = nThreads - 1;
+    if (nHeuristic < 0)
+        nHeuristic = 0;
+    nExact = nThreads - nHeuristic;
+
+    heuristicBest = Alloc_RouteDefinition();
+    heuristicBest->length  = maxRouteLen;
+    heuristicBest->nPlaced = nBags;
+    rootBound = RootBound();
+    stopHeuristics = 0;
+
+    threads = (HeuristicThread*) malloc((nHeuristic + 1) * sizeof(HeuristicThread));
+    for (t = 0; t < nHeuristic; t++)
+    {
+        threads[t].ring = nExact + t;
+        threads[t].seed = 12345u + 7919u * t;
+        pthread_create(&threads[t].thread, NULL, Heuristic, &threads[t]);
+    }
+
+    omp_set_num_threads(nExact);
+    res = useMask ? MaskRoute(NULL) : ShortestRoutePar(NULL);
+    omp_set_num_threads(nThreads);
+    proofTime = ProgressTime();
+
+    __atomic_store_n(&stopHeuristics, 1, __ATOMIC_RELAXED);
+    for (t = 0; t < nHeuristic; t++)
+        pthread_join(threads[t].thread, NULL);
+    free(threads);
+
+        // A search that finished proves there is no shorter route, so this only
+        // picks among equals; one stopped by its budget may have missed a
+        // shorter route a heuristic thread found
+    if (BetterRoute(heuristicBest->length, heuristicBest->path, res))
+        memcpy(res, heuristicBest, sizeof(RouteDefinition) + nBags);
+    free(heuristicBest);
+    return res;
+}
+
+    // Prints when the first route, a good route and 'res' were found and when
+    // the search was over. Call after Stop_Progress().
+void PortfolioReport(RouteDefinition *res)
+{
+    ProgressReport(res->length, nExact);
+    printf("Proven optimal after %.3f ms\n", proofTime * 1000);
+}
@@ -0,0 +1,34 @@
+/*
+ * Portfolio of heuristic and exact search for RaceTrap.
+ *
+ * Some threads run iterated local search: a nearest neighbour tour from a
+ * random bag, improved with 2-opt and Or-opt (Heuristic.h), then kicked
+ * with random double-bridge moves and improved again, keeping the kicked
+ * tour when it is shorter, and restarting after PF_KICKS kicks in a row that
+ * didn't help. The other threads run the exact search (ShortestRoutePar(),
+ * or MaskRoute() of MaskSearch.h).
+ *
+ * A heuristic thread that beats the incumbent lowers globalBest with
+ * UpdateBest(), so the exact threads prune against it at once, and pushes
+ * it to its own progress ring (Progress.h). The heuristic threads stop
+ * when the exact search is over, which proves the optimum, or as soon as
+ * the best route, whichever thread found it, reaches the lower bound of
+ * the root, which proves it too.
+ *
+ * The writer thread keeps every route with the time it was found, so
+ * PortfolioReport() can tell when the first route, a good route and the
+ * optimum were found and by which side, apart from the time to the proof.
+ */
+
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include "Route.h"
+
+#define PF_KICKS  50        // Kicks without improvement before a restart
+
+RouteDefinition *PortfolioRoute(int nHeuristic, int useMask);
+
+void PortfolioReport(RouteDefinition *res);
+
+#endif
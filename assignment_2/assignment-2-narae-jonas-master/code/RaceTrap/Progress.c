@@ -0,0 +1,188 @@
+/*
+ * Streaming of improvements through ring buffers, see Progress.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <omp.h>
+#include "Progress.h"
+
+#define EPSILON 1e-9
+
+static ProgressRing *rings = NULL;
+static int nRings = 0;
+static int printRoutes = 0;
+static int stopping = 0;
+static double started;
+static pthread_t writer;
+
+ProgressEvent *progressHistory = NULL;
+int nProgressHistory = 0;
+
+    // Takes the routes out of every ring, returns how many there were
+static int Drain(RouteDefinition *written)
+{
+    int r, n = 0;
+
+    for (r = 0; r < nRings; r++)
+    {
+        ProgressRing *ring = &rings[r];
+        unsigned long head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+        for (; ring->tail != head; n++)
+        {
+            ProgressRecord *rec = &ring->slots[ring->tail % PROGRESS_SLOTS];
+                // Every record, those of other rings may have been earlier
+            if (nProgressHistory % 64 == 0)
+                progressHistory = (ProgressEvent*) realloc(progressHistory,
+                                      (nProgressHistory + 64) * sizeof(ProgressEvent));
+            progressHistory[nProgressHistory].length = rec->length;
+            progressHistory[nProgressHistory].time   = rec->time;
+            progressHistory[nProgressHistory].ring   = r;
+            nProgressHistory++;
+            if (rec->length < written->length)
+            {
+                written->length = rec->length;
+                memcpy(written->path, rec->path, nBags);
+                if (printRoutes)
+                    printf("Best route so far %lf after %.3f s\n", rec->length, rec->time);
+                dump_data(written);
+            }
+                // The slot may be reused once tail has passed it
+            __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+        }
+    }
+    return n;
+}
+
+static void *Writer(void *arg)
+{
+    RouteDefinition *written = Alloc_RouteDefinition();
+    struct timespec nap = { 0, PROGRESS_SLEEP * 1000000L };
+
+    written->length  = maxRouteLen;
+    written->nPlaced = nBags;
+    for (;;)
+    {
+        int stop = __atomic_load_n(&stopping, __ATOMIC_ACQUIRE);
+        if (Drain(written) == 0)
+        {
+            if (stop)
+                break;
+            nanosleep(&nap, NULL);
+        }
+    }
+    fflush(stdout);
+    free(written);
+    return NULL;
+}
+
+/*
+ * Starts the writer thread with one ring per search thread. 'print' makes
+ * it print every improvement; with DO_DUMP it also dumps them.
+ */
+void Start_Progress(int n, int print)
+{
+    nRings      = n;
+    printRoutes = print;
+    stopping    = 0;
+    started     = omp_get_wtime();
+    free(progressHistory);
+    progressHistory  = NULL;
+    nProgressHistory = 0;
+    if (posix_memalign((void**) &rings, 64, n * sizeof(ProgressRing)) != 0)
+    {
+        printf("Error: couldn't allocate %d progress rings.\n", n);
+        exit(-1);
+    }
+    memset(rings, 0, n * sizeof(ProgressRing));
+    pthread_create(&writer, NULL, Writer, NULL);
+}
+
+    // Seconds since Start_Progress(), the clock of the records
+double ProgressTime()
+{
+    return omp_get_wtime() - started;
+}
+
+    // The ring of search thread 'i', NULL if there is no writer
+ProgressRing *Progress_Ring(int i)
+{
+    return rings != NULL && i < nRings ? &rings[i] : NULL;
+}
+
+    // Called by the owner of 'ring' only. Never waits: returns false and
+    // drops the route if the ring is full.
+int PushProgress(ProgressRing *ring, double length, unsigned char *path)
+{
+    unsigned long head = ring->head;
+
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= PROGRESS_SLOTS)
+    {
+        ring->dropped++;
+        return 0;
+    }
+    ProgressRecord *rec = &ring->slots[head % PROGRESS_SLOTS];
+    rec->length = length;
+    rec->time   = omp_get_wtime() - started;
+    memcpy(rec->path, path, nBags);
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+    // Lets the writer finish the rings and stops it, returns the number of dropped routes
+long Stop_Progress()
+{
+    long dropped = 0;
+    int r;
+
+    if (rings == NULL)
+        return 0;
+    __atomic_store_n(&stopping, 1, __ATOMIC_RELEASE);
+    pthread_join(writer, NULL);
+    for (r = 0; r < nRings; r++)
+        dropped += rings[r].dropped;
+    free(rings);
+    rings = NULL;
+    nRings = 0;
+    return dropped;
+}
+
+    // The first route found no longer than 'length', -1 if none was
+static int FoundAt(double length)
+{
+    int i, first = -1;
+
+    for (i = 0; i < nProgressHistory; i++)
+        if (progressHistory[i].length <= length + EPSILON &&
+            (first < 0 || progressHistory[i].time < progressHistory[first].time))
+            first = i;
+    return first;
+}
+
+static void PrintFound(const char *what, int i, int nSearch)
+{
+    if (i < 0)
+        printf("%s: none\n", what);
+    else
+        printf("%s %lf after %.3f ms, by the %s\n", what, progressHistory[i].length,
+               progressHistory[i].time * 1000, progressHistory[i].ring < nSearch ? "search" : "heuristics");
+}
+
+/*
+ * Prints when the first route, one within PROGRESS_GOOD of 'best' and
+ * 'best' itself came through the rings, and whether the search (rings
+ * 0..nSearch-1) or a heuristic thread found them. Call after Stop_Progress().
+ */
+void ProgressReport(double best, int nSearch)
+{
+    char what[64];
+
+    PrintFound("First route", FoundAt(maxRouteLen), nSearch);
+    sprintf(what, "Good route (%g%%)", PROGRESS_GOOD * 100);
+    PrintFound(what, FoundAt(best * (1.0 + PROGRESS_GOOD)), nSearch);
+    PrintFound("Best route", FoundAt(best), nSearch);
+}
@@ -0,0 +1,60 @@
+/*
+ * Streaming of the improvements a RaceTrap search finds, off the search
+ * threads.
+ *
+ * Every search thread gets its own ring buffer with a single producer (the
+ * thread) and a single consumer (a writer thread), so pushing a new best
+ * route is a copy into a slot and one atomic store: no lock, no system
+ * call. When the ring is full the route is dropped rather than waiting; a
+ * later, shorter one will follow anyway. The writer thread polls the rings,
+ * prints the routes that improve on what it has seen (the rings of
+ * different threads may be drained out of order) and appends them to the
+ * dump file with dump_data(). It also keeps every route it takes out of the rings, with
+ * its time and ring, in progressHistory, from which ProgressReport() tells
+ * when the first, a good and the best route were found.
+ */
+
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include "Route.h"
+
+#define PROGRESS_SLOTS 64   // Routes per ring, a power of two
+#define PROGRESS_SLEEP 1    // Milliseconds the writer sleeps when the rings are empty
+#define PROGRESS_GOOD  0.01 // A good route is this close to the best one
+
+typedef struct {
+    double        length;
+    double        time;             // Seconds since Start_Progress()
+    unsigned char path[MAX_BAGS];
+} ProgressRecord;
+
+typedef struct {
+    double length;
+    double time;            // Seconds since Start_Progress()
+    int    ring;            // Ring it came through, that is the thread that found it
+} ProgressEvent;
+
+typedef struct {
+    ProgressRecord slots[PROGRESS_SLOTS];
+    unsigned long  head __attribute__((aligned(64)));  // Written by the search thread only
+    unsigned long  tail __attribute__((aligned(64)));  // Written by the writer thread only
+    long           dropped;                            // Routes the ring had no room for
+} ProgressRing;
+
+extern ProgressEvent *progressHistory; // Every route the writer took, in the order it did
+extern int nProgressHistory;           // kept until the next Start_Progress()
+
+void Start_Progress(int nRings, int print);
+
+double ProgressTime();
+
+ProgressRing *Progress_Ring(int i);
+
+int PushProgress(ProgressRing *ring, double length, unsigned char *path);
+
+long Stop_Progress();
+
+void ProgressReport(double best, int nSearch);
+
+#endif
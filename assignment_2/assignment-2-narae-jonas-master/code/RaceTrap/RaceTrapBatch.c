@@ -0,0 +1,355 @@
+/*
+ * RaceTrap for many instances: solves every route of a batch in one run
+ * and writes one record per instance.
+ *
+ * ./RaceTrapBatch [cold] [round] [routes] [tt[=depth]] [leaf=bags] [budget=seconds]
+ *                 [threads=N] [grain=bags] [large=bags] [none|minedge|onetree] file
+ *
+ * 'file' is either a multi-instance file, route definitions in the format
+ * of route.dat one after the other, or a manifest that names one route file
+ * per line (blank lines and lines starting with # are skipped). Instances
+ * of at least 'large' bags are solved one at a time on all threads with
+ * ShortestRoutePar(), the others one per thread with ShortestRoute().
+ *
+ * The search keeps its instance in globals (Route.h), so every worker is a
+ * process of its own, forked once, that takes instance after instance from
+ * a shared counter and writes its results into shared memory. The parent
+ * never enters an OpenMP region, so the workers may fork from it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <omp.h>
+#include "Timer.h"
+#include "Route.h"
+#include "Search.h"
+#include "Heuristic.h"
+#include "TransTable.h"
+#include "LeafSolver.h"
+
+#define BATCH_LARGE 32      // Default of 'large', fewest bags solved on all threads
+
+#define RESULT_FAILED  0    // The worker died, or never got to it
+#define RESULT_OPTIMAL 1
+#define RESULT_STOPPED 2    // Stopped at the time budget, see lowerBound
+
+typedef struct {
+    char *file;
+    long  offset;           // Where its route definition starts in 'file'
+    int   index;            // Place in a multi-instance file, -1 for a file of its own
+    int   nBags;
+} Instance;
+
+typedef struct {
+    int           status;   // One of the RESULT_* values
+    double        length;
+    double        lowerBound;
+    double        seconds;  // Reading, heuristic and search
+    long          nodes;
+    unsigned char path[MAX_BAGS];
+} Result;
+
+static Instance *instances = NULL;
+static int       nInstances = 0;
+static Result   *results;   // Shared with the workers
+static long     *nextSmall; // Next entry of the small instances to take, shared
+
+static int    warmStart = 1;
+static double budget = 0.0; // Seconds per instance, 0 for no limit
+
+static void AddInstance(char *file, long offset, int index, int bags)
+{
+    if (nInstances % 64 == 0)
+        instances = (Instance*) realloc(instances, (nInstances + 64) * sizeof(Instance));
+    instances[nInstances].file   = file;
+    instances[nInstances].offset = offset;
+    instances[nInstances].index  = index;
+    instances[nInstances].nBags  = bags;
+    nInstances++;
+}
+
+    // Finds the instances of a multi-instance file, skipping their coordinates
+static void ScanInstances(char *name, FILE *file)
+{
+    int bags, x, y, i;
+    long offset = ftell(file);
+
+    while (fscanf(file, "%d", &bags) == 1)
+    {
+        for (i = 0; i < bags; i++)
+            if (fscanf(file, "%d %d", &x, &y) != 2)
+            {
+                printf("Error: instance %d of %s is cut short.\n", nInstances, name);
+                exit(-1);
+            }
+        AddInstance(name, offset, nInstances, bags);
+        offset = ftell(file);
+    }
+}
+
+    // Reads the names in a manifest, and the number of bags of each
+static void ScanManifest(FILE *file)
+{
+    char line[4096];
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char *name = line, *end;
+        FILE *route;
+        int bags = 0;
+
+        while (isspace((unsigned char) *name))
+            name++;
+        for (end = name + strlen(name); end > name && isspace((unsigned char) end[-1]); end--)
+            ;
+        *end = '\0';
+        if (*name == '\0' || *name == '#')
+            continue;
+        route = fopen(name, "r");
+        if (route != NULL && fscanf(route, "%d", &bags) != 1)
+            bags = 0;
+        if (route != NULL)
+            fclose(route);
+            // Unreadable files are kept, to be reported as failed
+        AddInstance(strdup(name), 0, -1, bags);
+    }
+}
+
+static void ReadBatch(char *name)
+{
+    FILE *file = fopen(name, "r");
+    int c;
+
+    if (file == NULL)
+    {
+        printf("Error: couldn't open %s.\n", name);
+        exit(-1);
+    }
+        // A multi-instance file starts with a number of bags, a manifest with a name
+    while ((c = fgetc(file)) != EOF && isspace(c))
+        ;
+    ungetc(c, file);
+    if (isdigit(c))
+        ScanInstances(name, file);
+    else
+        ScanManifest(file);
+    fclose(file);
+}
+
+    // Solves instance 'i' in this process and fills in results[i]
+static void Solve(int i, int parallel)
+{
+    Instance *inst = &instances[i];
+    Result *r = &results[i];
+    RouteDefinition *seed = NULL, *res;
+    FILE *file = fopen(inst->file, "r");
+    double t0 = omp_get_wtime();
+
+    if (file == NULL)
+        return;
+    if (fseek(file, inst->offset, SEEK_SET) != 0)
+    {
+        fclose(file);
+        return;
+    }
+    ReadRouteFrom(file);
+    fclose(file);
+
+    globalBest     = maxRouteLen;
+    searchStopped  = 0;
+    searchDeadline = budget > 0 ? t0 + budget : 0.0;
+    if (warmStart)
+        seed = HeuristicRoute();
+    res = parallel ? ShortestRoutePar(seed) : ShortestRoute(seed);
+
+    r->length     = res->length;
+    r->lowerBound = lowerBound;
+    r->nodes      = nodesExpanded;
+    memcpy(r->path, res->path, nBags);
+    r->seconds    = omp_get_wtime() - t0;
+    r->status     = searchStopped ? RESULT_STOPPED : RESULT_OPTIMAL;
+    free(seed);
+    free(res);
+    FreeRoute();
+}
+
+    // Worker process for the small instances, listed in 'small'
+static void SmallWorker(int *small, int nSmall)
+{
+    long k;
+
+    omp_set_num_threads(1);
+    while ((k = __atomic_fetch_add(nextSmall, 1, __ATOMIC_RELAXED)) < nSmall)
+        Solve(small[k], 0);
+}
+
+    // Starts 'n' workers for the small instances, and another one for every
+    // worker that dies while instances are left
+static void RunSmall(int *small, int nSmall, int n)
+{
+    int live = 0, status;
+
+    for (;;)
+    {
+        for (; live < n && __atomic_load_n(nextSmall, __ATOMIC_RELAXED) < nSmall; live++)
+        {
+            fflush(stdout);
+            if (fork() == 0)
+            {
+                SmallWorker(small, nSmall);
+                _exit(0);
+            }
+        }
+        if (live == 0 || wait(&status) < 0)
+            break;
+        live--;
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+            n--;    // Finished, no need to replace it
+    }
+}
+
+    // Solves one large instance on all threads, in a process of its own
+static void RunLarge(int i, int nThreads)
+{
+    int status;
+
+    fflush(stdout);
+    if (fork() == 0)
+    {
+        omp_set_num_threads(nThreads);
+        Solve(i, 1);
+        _exit(0);
+    }
+    wait(&status);
+}
+
+    // One line: name, bags, status, and unless it failed the length, lower
+    // bound, nodes, milliseconds and threads (and the route)
+static void PrintRecord(int i, int routes, int nThreads)
+{
+    Instance *inst = &instances[i];
+    Result *r = &results[i];
+    static const char *statusNames[] = { "failed", "optimal", "stopped" };
+    int k;
+
+    if (inst->index >= 0)
+        printf("%s#%d", inst->file, inst->index);
+    else
+        printf("%s", inst->file);
+    printf(" %d %s", inst->nBags, statusNames[r->status]);
+    if (r->status != RESULT_FAILED)
+    {
+        printf(" %lf %lf %ld %.3f %d", r->length, r->lowerBound, r->nodes, r->seconds * 1000,
+               nThreads);
+        if (routes)
+            for (k = 0; k < inst->nBags; k++)
+                printf(" %d", r->path[k]);
+    }
+    printf("\n");
+}
+
+int main (int argc, char **argv)
+{
+    char buf[256];
+    char *batch = NULL;
+    int nThreads = omp_get_max_threads();  // OMP_NUM_THREADS, or every core
+    int large = BATCH_LARGE;
+    int routes = 0;
+    int *small, nSmall = 0, nLarge = 0, nFailed = 0, i;
+    void *shared;
+
+    boundMode = BOUND_ONETREE;
+
+    // ./RaceTrapBatch [cold] [round] [routes] [tt[=depth]] [leaf=bags] [budget=seconds] [threads=N] [grain=bags] [large=bags] [none|minedge|onetree] file
+    for (i = 1; i < argc; i++) {
+        if (strcmp("cold", argv[i]) == 0) {
+            warmStart = 0;  // no heuristic route before the search
+        }
+        else if (strcmp("round", argv[i]) == 0) {
+            roundDistances = 1;  // integer distances, like TSPLIB
+        }
+        else if (strcmp("routes", argv[i]) == 0) {
+            routes = 1;     // end every record with the route
+        }
+        else if (strncmp("tt", argv[i], 2) == 0 && (argv[i][2] == '\0' || argv[i][2] == '=')) {
+            ttDepth = argv[i][2] ? atoi(argv[i] + 3) : TT_DEFAULT_DEPTH;  // dominance table
+        }
+        else if (strncmp("leaf=", argv[i], 5) == 0) {
+            leafBags = ParseCount(argv[i], 0, LEAF_MAX);  // try all orders of the last bags
+        }
+        else if (strncmp("budget=", argv[i], 7) == 0) {
+            budget = atof(argv[i] + 7);    // per instance
+        }
+        else if (strncmp("threads=", argv[i], 8) == 0) {
+            nThreads = ParseCount(argv[i], 1, INT_MAX);
+        }
+        else if (strncmp("grain=", argv[i], 6) == 0) {
+            splitGrain = ParseCount(argv[i], 1, INT_MAX);  // fewest unplaced bags to hand to another thread
+        }
+        else if (strncmp("large=", argv[i], 6) == 0) {
+            large = ParseCount(argv[i], 1, INT_MAX);  // fewest bags to solve on all threads
+        }
+        else if (ParseBoundMode(argv[i]) >= 0) {
+            boundMode = ParseBoundMode(argv[i]);
+        }
+        else if (batch == NULL) {
+            batch = argv[i];
+        }
+        else {
+            printf("Unknown argument %s\n", argv[i]);
+            exit(-1);
+        }
+    }
+    if (batch == NULL)
+    {
+        printf("Usage: ./RaceTrapBatch [options] manifest-or-instances\n");
+        exit(-1);
+    }
+
+    ReadBatch(batch);
+    shared = mmap(NULL, nInstances * sizeof(Result) + sizeof(long), PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+    {
+        printf("Error: couldn't map the results of %d instances.\n", nInstances);
+        exit(-1);
+    }
+    results   = (Result*) shared;
+    nextSmall = (long*) (results + nInstances);
+    small = (int*) malloc((nInstances + 1) * sizeof(int));
+
+    Init_Timers(TIMER_MONOTONIC);
+    Timer_Start("batch");
+        // The large instances first, so that the small ones don't wait behind them
+    for (i = 0; i < nInstances; i++)
+    {
+        if (instances[i].nBags >= large)
+        {
+            RunLarge(i, nThreads);
+            nLarge++;
+        }
+        else
+            small[nSmall++] = i;
+    }
+    RunSmall(small, nSmall, nThreads < nSmall ? nThreads : nSmall);
+    TimeString(Timer_Stop(), buf);
+
+    printf("# instance bags status length lower-bound nodes ms threads%s\n", routes ? " route" : "");
+    for (i = 0; i < nInstances; i++)
+    {
+        PrintRecord(i, routes, instances[i].nBags >= large ? nThreads : 1);
+        if (results[i].status == RESULT_FAILED)
+            nFailed++;
+    }
+    printf("# %d instances (%d large, %d failed) with bound %s on %d threads, it took %s\n",
+           nInstances, nLarge, nFailed, BoundModeName(boundMode), nThreads, buf);
+
+    free(small);
+    munmap(shared, nInstances * sizeof(Result) + sizeof(long));
+    return 0;
+}
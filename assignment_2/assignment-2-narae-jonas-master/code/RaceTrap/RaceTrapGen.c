@@ -0,0 +1,169 @@
+/*
+ * Generator of RaceTrap instances in the format of route.dat.
+ *
+ *   ./RaceTrapGen [bags=N] [seed=S] [size=S] [clusters=K] [uniform|clustered|grid] [file]
+ *
+ * uniform:   bags anywhere in the size x size square
+ * clustered: bags around K centres, normally distributed
+ * grid:      bags on a square lattice, moved a little off their points
+ *
+ * The same arguments give the same instance on every machine, the random
+ * numbers are splitmix64 rather than rand(). No two bags share a place.
+ * Writes to stdout unless given a file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#define GEN_UNIFORM   0
+#define GEN_CLUSTERED 1
+#define GEN_GRID      2
+
+#define GEN_TRIES 1000      // Draws of one bag before giving up on a free place
+
+static const char *kindNames[] = { "uniform", "clustered", "grid" };
+
+static uint64_t state;
+
+static uint64_t Next()
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+    // Uniform in [0, 1)
+static double Uniform()
+{
+    return (Next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+    // Standard normal, Box-Muller
+static double Normal()
+{
+    double u = Uniform(), v = Uniform();
+    return sqrt(-2.0 * log(1.0 - u)) * cos(2 * M_PI * v);
+}
+
+static int Clamp(double x, int size)
+{
+    return x < 0 ? 0 : x > size ? size : (int) lround(x);
+}
+
+int main (int argc, char **argv)
+{
+    int bags = 20, size = 500, clusters = 0, kind = GEN_UNIFORM;
+    uint64_t seed = 1;
+    char *name = NULL;
+    FILE *out = stdout;
+    int *x, *y, *cx, *cy;
+    int i, j, k, tries, cols;
+    double spacing;
+
+    for (i = 1; i < argc; i++) {
+        if (strncmp("bags=", argv[i], 5) == 0) {
+            bags = atoi(argv[i] + 5);
+        }
+        else if (strncmp("seed=", argv[i], 5) == 0) {
+            seed = strtoull(argv[i] + 5, NULL, 10);
+        }
+        else if (strncmp("size=", argv[i], 5) == 0) {
+            size = atoi(argv[i] + 5);   // coordinates are 0..size
+        }
+        else if (strncmp("clusters=", argv[i], 9) == 0) {
+            clusters = atoi(argv[i] + 9);   // centres of a clustered instance
+        }
+        else if (strcmp(kindNames[GEN_UNIFORM], argv[i]) == 0) {
+            kind = GEN_UNIFORM;
+        }
+        else if (strcmp(kindNames[GEN_CLUSTERED], argv[i]) == 0) {
+            kind = GEN_CLUSTERED;
+        }
+        else if (strcmp(kindNames[GEN_GRID], argv[i]) == 0) {
+            kind = GEN_GRID;
+        }
+        else if (name == NULL && strchr(argv[i], '=') == NULL) {
+            name = argv[i];
+        }
+        else {
+            printf("Unknown argument %s\n", argv[i]);
+            exit(-1);
+        }
+    }
+    if (bags < 1 || size < 1 || (long) (size + 1) * (size + 1) < bags)
+    {
+        printf("Error: can't place %d bags apart in a %d x %d square.\n", bags, size, size);
+        exit(-1);
+    }
+    if (clusters <= 0)
+        clusters = bags / 8 > 2 ? bags / 8 : 2;
+
+    state = seed;
+    x  = (int*) malloc(bags * sizeof(int));
+    y  = (int*) malloc(bags * sizeof(int));
+    cx = (int*) malloc(clusters * sizeof(int));
+    cy = (int*) malloc(clusters * sizeof(int));
+    for (k = 0; k < clusters; k++)
+    {
+        cx[k] = Clamp(Uniform() * size, size);
+        cy[k] = Clamp(Uniform() * size, size);
+    }
+        // Lattice points are 'spacing' apart, with room for all the bags
+    cols = (int) ceil(sqrt((double) bags));
+    spacing = (double) size / cols;
+
+    for (i = 0; i < bags; i++)
+    {
+        for (tries = 0; tries < GEN_TRIES; tries++)
+        {
+            switch (kind)
+            {
+            case GEN_CLUSTERED:
+                k = Next() % clusters;
+                x[i] = Clamp(cx[k] + Normal() * size / (4 * sqrt(clusters)), size);
+                y[i] = Clamp(cy[k] + Normal() * size / (4 * sqrt(clusters)), size);
+                break;
+
+            case GEN_GRID:
+                    // The i-th lattice point, up to a tenth of the spacing off
+                x[i] = Clamp((i % cols + 0.5 + (Uniform() - 0.5) / 5) * spacing, size);
+                y[i] = Clamp((i / cols + 0.5 + (Uniform() - 0.5) / 5) * spacing, size);
+                break;
+
+            default:
+                x[i] = Clamp(Uniform() * size, size);
+                y[i] = Clamp(Uniform() * size, size);
+            }
+            for (j = 0; j < i && (x[j] != x[i] || y[j] != y[i]); j++)
+                ;
+            if (j == i)
+                break;
+        }
+        if (tries == GEN_TRIES)
+        {
+            printf("Error: found no free place for bag %d, try a larger size.\n", i);
+            exit(-1);
+        }
+    }
+
+    if (name != NULL && (out = fopen(name, "w")) == NULL)
+    {
+        printf("Error: couldn't write %s.\n", name);
+        exit(-1);
+    }
+    fprintf(out, "%d\n", bags);
+    for (i = 0; i < bags; i++)
+        fprintf(out, "%d %d\n", x[i], y[i]);
+    if (out != stdout)
+        fclose(out);
+
+    free(x);
+    free(y);
+    free(cx);
+    free(cy);
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * RaceTrap for large instances: a good route through thousands of bags,
+ * without proof that it is the shortest (see LargeRoute.h and LargeTour.h).
+ *
+ * ./RaceTrapLarge [dump] [round] [k=candidates] [piece=positions] [threads=N] [file]
+ *
+ * Reads ./route.dat unless another file is given, in the route.dat or the
+ * TSPLIB format.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "Timer.h"
+#include "LargeRoute.h"
+#include "LargeTour.h"
+
+    // Writes the tour to data/racetrap.data, in the format of dump_data()
+static void DumpTour(int *tour)
+{
+    FILE *fp;
+    int i;
+
+    remove("data/racetrap.data");
+    fp = fopen("data/racetrap.data", "w");
+    if (fp == NULL)
+        return;
+    for (i = 0; i < nPoints; i++)
+        fprintf(fp, "%d ", tour[i]);
+    fprintf(fp, "\n");
+    fclose(fp);
+}
+
+int main (int argc, char **argv)
+{
+    const char *file = "./route.dat";
+    char buf[256];
+    int k = LARGE_CANDIDATES, piece = LARGE_PIECE;
+    int nThreads = omp_get_max_threads();  // OMP_NUM_THREADS, or every core
+    int *tour;
+    double length, first;
+
+    // ./RaceTrapLarge [dump] [round] [k=candidates] [piece=positions] [threads=N] [file]
+    for (int i = 1; i < argc; i++) {
+        if (strcmp("dump", argv[i]) == 0) {
+            DO_DUMP = 1;
+        }
+        else if (strcmp("round", argv[i]) == 0) {
+            roundDistances = 1;  // integer distances, like TSPLIB
+        }
+        else if (strncmp("k=", argv[i], 2) == 0) {
+            k = ParseCount(argv[i], 1, LARGE_MAX_CANDIDATES);  // length of the candidate lists
+        }
+        else if (strncmp("piece=", argv[i], 6) == 0) {
+            piece = ParseCount(argv[i], LARGE_MIN_PIECE, INT_MAX);  // positions per piece of the first rounds
+        }
+        else if (strncmp("threads=", argv[i], 8) == 0) {
+            nThreads = ParseCount(argv[i], 1, INT_MAX);
+        }
+        else {
+            file = argv[i];
+        }
+    }
+
+    omp_set_num_threads(nThreads);
+    Init_Timers(TIMER_MONOTONIC);
+    Timer_Start("solve");
+    Timer_Start("read route");
+    ReadLargeRoute(file);
+    Timer_Stop();
+    Timer_Start("candidates");
+    BuildCandidates(k);
+    Timer_Stop();
+
+    tour = (int*) malloc(nPoints * sizeof(int));
+    Timer_Start("heuristic");
+    first = GreedyTour(tour);
+    Timer_Stop();
+    Timer_Start("search");
+    length = ImproveTour(tour, piece);
+    RotateLargeTour(tour);
+    Timer_Stop();
+    TimeString(Timer_Stop(), buf);
+
+    printf("Route length is %lf it took %s\n", length, buf);
+    printf("%d bags read in %.0f ms, %d candidates each in %.0f ms, local search %.0f ms\n",
+           nPoints, Timer_Total("solve/read route") * 1000, nCandidates,
+           Timer_Total("solve/candidates") * 1000, Timer_Total("solve/search") * 1000);
+    printf("Greedy route length was %lf\n", first);
+
+    if (DO_DUMP)
+        DumpTour(tour);
+
+    free(tour);
+    FreeLargeRoute();
+    return 0;
+}
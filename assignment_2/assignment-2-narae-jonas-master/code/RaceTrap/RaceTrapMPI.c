@@ -0,0 +1,127 @@
+/*
+ * RaceTrap implementation based on RaceTrap.java
+ *
+ * Created on 22. juni 2000, 13:48
+ * 
+ * Brian Vinter
+ * 
+ * Modified by John Markus Bjørndalen, 2008-12-04, 2009-10-15. 
+ * Modified by Sergiusz Michalik, 2018-09-20
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <mpi.h>
+#include "Timer.h"
+#include "Route.h"
+#include "Search.h"
+#include "SearchMPI.h"
+#include "Heuristic.h"
+#include "TransTable.h"
+#include "LeafSolver.h"
+#include <omp.h>
+
+
+int main (int argc, char **argv) 
+{
+    RouteDefinition *res, *seed = NULL;
+    char buf[256];
+    int warmStart = 1;
+    double budget = 0.0;    // seconds for the whole run, 0 for no limit
+    int rank;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    
+    // mpirun -np <ranks> ./RaceTrapMPI [dump] [cold] [round] [tt[=depth]] [leaf=bags] [budget=seconds] [grain=bags] [none|minedge|onetree]
+    for (int i = 1; i < argc; i++) {
+        if (strcmp("dump", argv[i]) == 0) {
+            DO_DUMP = rank == 0;  // only rank 0 writes the file
+        }
+        else if (strcmp("cold", argv[i]) == 0) {
+            warmStart = 0;  // no heuristic route before the search
+        }
+        else if (strcmp("round", argv[i]) == 0) {
+            roundDistances = 1;  // integer distances, like TSPLIB
+        }
+        else if (strncmp("tt", argv[i], 2) == 0 && (argv[i][2] == '\0' || argv[i][2] == '=')) {
+            ttDepth = argv[i][2] ? atoi(argv[i] + 3) : TT_DEFAULT_DEPTH;  // dominance table
+        }
+        else if (strncmp("grain=", argv[i], 6) == 0) {
+            splitGrain = atoi(argv[i] + 6);  // fewest unplaced bags to hand to another rank
+        }
+        else if (strncmp("budget=", argv[i], 7) == 0) {
+            budget = atof(argv[i] + 7);    // anytime mode: stop searching after this long
+        }
+        else if (strncmp("leaf=", argv[i], 5) == 0) {
+            leafBags = ParseCount(argv[i], 0, LEAF_MAX);  // try all orders of the last bags
+        }
+        else if (ParseBoundMode(argv[i]) >= 0) {
+            boundMode = ParseBoundMode(argv[i]);
+        }
+        else {
+            if (rank == 0)
+                printf("Unknown argument %s\n", argv[i]);
+            MPI_Finalize();
+            exit(-1);
+        }
+    }
+
+    Init_Timers(TIMER_MONOTONIC);
+    Timer_Start("read route");
+    ReadRoute();
+    Timer_Stop();
+    
+        // Set up an initial path that goes through each bag in turn. 
+    res = Alloc_RouteDefinition(); 
+    for (int i = 0; i < nBags; i++)
+        res->path[i] = (unsigned char) i;
+    dump_data(res);
+    free(res);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    Timer_Start("solve");
+    omp_set_num_threads(1); // one thread per rank
+    if (budget > 0)
+        searchDeadline = omp_get_wtime() + budget;
+        // New best routes go to a writer thread, the search doesn't wait for the output
+    if (DO_DUMP || (budget > 0 && rank == 0))
+        Start_Progress(omp_get_max_threads(), budget > 0 && rank == 0);
+        // Every rank builds the same heuristic route, no need to send it
+    if (warmStart)
+    {
+        Timer_Start("heuristic");
+        seed = HeuristicRoute();
+        Timer_Stop();
+    }
+        // Find the best route
+    Timer_Start("search");
+    res = ShortestRouteMPI(seed);
+    Timer_Stop();
+    Stop_Progress();
+    TimeString(Timer_Stop(), buf);
+    dump_data(res);
+    
+    if (rank == 0) {
+        int size;
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+        printf("Route length is %lf it took %s\n", res->length, buf);
+        printf("Looked at %ld nodes with bound %s on %d ranks\n", nodesExpanded, BoundModeName(boundMode), size);
+        if (seed != NULL)
+            printf("Heuristic route length was %lf\n", seed->length);
+        if (budget > 0)
+            printf("Lower bound is %lf, gap %.3f%%%s\n", lowerBound,
+                   100.0 * (res->length - lowerBound) / res->length,
+                   searchStopped ? ", stopped at the time budget" : "");
+    }
+    
+    if (DO_DUMP) {
+        close_dump();
+    }
+
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,315 @@
+/*
+ * RaceTrap implementation based on RaceTrap.java
+ *
+ * Created on 22. juni 2000, 13:48
+ *
+ * Brian Vinter
+ *
+ * Modified by John Markus Bjørndalen, 2008-12-04, 2009-10-15.
+ * Modified by Sergiusz Michalik, 2018-09-20
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+#include "Route.h"
+
+
+int      nBags = 0;             // Number of grain-bags
+Coord   *bagCoords;             // Coordinates for the grain-bags
+double  *distanceTable;         // Distances between any two grain-bags, one padded row per bag
+int      distanceStride;        // Doubles per row of distanceTable, a multiple of 8 (64 bytes)
+unsigned char *neighbours;      // The other bags of every bag, nearest first, nBags-1 per bag
+int      roundDistances = 0;    // true for distances rounded to integers like TSPLIB (EUC_2D)
+double   maxRouteLen = 10E100;  // Initial best distance, must be longer than any possible route
+double   globalBest  = 10E100;  // Bounding variable
+
+static FILE *fp;
+int DO_DUMP = 0; // true if we want to dump the iterations to the file
+
+void dump_data(RouteDefinition *route)
+{
+  int i;
+  if (!DO_DUMP)
+    return;
+
+  if (fp == NULL) {
+      remove("data/racetrap.data");
+    fp = fopen("data/racetrap.data", "a+");
+  }
+  /* Stores the data as a Python datastructure for easy inspection and plotting
+   */
+  printf("dumping data\n");
+  for (i = 0; i < nBags; i++) {
+      fprintf(fp, "%d ", route->path[i]);
+  }
+  fprintf(fp, "\n");
+}
+
+void close_dump()
+{
+    if (fp != NULL) {
+        fclose(fp);
+        fp = NULL;
+    }
+}
+
+RouteDefinition* Alloc_RouteDefinition()
+{
+    if (nBags <= 0)
+    {
+        fprintf(stderr, "Error: Alloc_RouteDefinition called with invalid nBags (%d)\n", nBags);
+        exit(-1);
+    }
+        // NB: The +nBags*sizeof.. trick "expands" the path[0] array in RouteDefintion
+        // to a path[nBags] array.
+    RouteDefinition *def = NULL;
+    return (RouteDefinition*) malloc(sizeof(RouteDefinition) + nBags * sizeof(def->path[0]));
+}
+
+    // In the desert, the shortest route is a straight line :)
+double EuclidDist(Coord *from, Coord *to)
+{
+    double dx = fabs(from->x - to->x);
+    double dy = fabs(from->y - to->y);
+    return sqrt(dx*dx + dy*dy);
+}
+
+    // Reads ./route.dat and generates a distance-table
+void ReadRoute()
+{
+    FILE *file = fopen("./route.dat", "r");
+
+    if (file == NULL)
+    {
+        printf("Error: couldn't open ./route.dat.\n");
+        exit(-1);
+    }
+    ReadRouteFrom(file);
+    fclose(file);
+}
+
+    // Reads one route definition (the number of bags, then their coordinates)
+    // from the current position of 'file' and generates a distance-table
+void ReadRouteFrom(FILE *file)
+{
+    int i,j;
+
+        // Read how many bags there are
+    if (fscanf(file, "%d", &nBags) != 1)
+    {
+        printf("Error: couldn't read number of bags from route definition file.\n");
+        exit(-1);
+    }
+    if (nBags < 1 || nBags > MAX_BAGS)
+    {
+        printf("Error: %d bags, this program handles 1 to %d (use RaceTrapLarge).\n", nBags, MAX_BAGS);
+        exit(-1);
+    }
+
+        // Allocate array of bag coords.
+    bagCoords = (Coord*) malloc(nBags * sizeof(Coord));
+
+        // Read the coordinates of each grain bag
+    for (i = 0; i < nBags; i++)
+    {
+        if (fscanf(file,"%d %d", &bagCoords[i].x, &bagCoords[i].y) != 2)
+        {
+            printf("Error: missing or invalid definition of coordinate %d.\n", i);
+            exit(-1);
+        }
+    }
+
+        // One block for the whole table, each row starting on a cache line
+    distanceStride = (nBags + 7) & ~7;
+    if (posix_memalign((void**) &distanceTable, 64, nBags * distanceStride * sizeof(double)) != 0)
+    {
+        printf("Error: couldn't allocate the distance table for %d bags.\n", nBags);
+        exit(-1);
+    }
+    neighbours = (unsigned char*) malloc(nBags * (nBags - 1) + 1);
+
+        // Compute the distances between each of the grain bags, and sort the other
+        // bags of each bag by distance (equal distances by bag number). Rows are
+        // independent, so they are spread over the threads.
+    #pragma omp parallel for private(j) schedule(dynamic, 16)
+    for (i = 0; i < nBags; i++)
+    {
+        double *row = distanceTable + i * distanceStride;
+        unsigned char *list = neighbours + i * (nBags - 1);
+        int n = 0, k;
+
+        for (j = 0; j < nBags; j++)
+        {
+            row[j] = EuclidDist(&bagCoords[i], &bagCoords[j]);
+            if (roundDistances)
+                row[j] = (int) (row[j] + 0.5);
+        }
+        for (j = nBags; j < distanceStride; j++)
+            row[j] = 0.0;
+
+            // Insertion sort, the lists are short
+        for (j = 0; j < nBags; j++)
+        {
+            if (j == i)
+                continue;
+            for (k = n; k > 0 && row[list[k-1]] > row[j]; k--)
+                list[k] = list[k-1];
+            list[k] = (unsigned char) j;
+            n++;
+        }
+    }
+}
+
+    // Frees what ReadRoute() allocated and forgets the best route, so that
+    // another route can be read
+void FreeRoute()
+{
+    free(bagCoords);
+    free(distanceTable);
+    free(neighbours);
+    bagCoords     = NULL;
+    distanceTable = NULL;
+    neighbours    = NULL;
+    nBags         = 0;
+    globalBest    = maxRouteLen;
+}
+
+    // Distance from bag 'i' to bag 'j', rounded as ReadRoute() does
+static double BagDistance(int i, int j)
+{
+    double d = EuclidDist(&bagCoords[i], &bagCoords[j]);
+    return roundDistances ? (int) (d + 0.5) : d;
+}
+
+/*
+ * Builds the tables of the current bags from those of 'oldBags' bags after
+ * bag 'changed' got new coordinates or was added (-1 for none) and bag
+ * 'removed' (-1 for none) was taken out and the bags after it moved down.
+ * Only the distances of 'changed' are computed, the rest are copied. The
+ * other neighbour lists keep their order with 'changed' put back in its
+ * place, only its own list is sorted from scratch.
+ */
+static void UpdateTables(int oldBags, int changed, int removed)
+{
+    int oldStride = distanceStride;
+    double *oldTable = distanceTable;
+    unsigned char *oldNeighbours = neighbours;
+    int i, j, n, k, oi;
+
+    distanceStride = (nBags + 7) & ~7;
+    if (posix_memalign((void**) &distanceTable, 64, nBags * distanceStride * sizeof(double)) != 0)
+    {
+        printf("Error: couldn't allocate the distance table for %d bags.\n", nBags);
+        exit(-1);
+    }
+    neighbours = (unsigned char*) malloc(nBags * (nBags - 1) + 1);
+
+    for (i = 0; i < nBags; i++)
+    {
+        double *row = distanceTable + i * distanceStride;
+        unsigned char *list = neighbours + i * (nBags - 1);
+
+        oi = removed >= 0 && i >= removed ? i + 1 : i;
+        for (j = 0; j < nBags; j++)
+        {
+            int oj = removed >= 0 && j >= removed ? j + 1 : j;
+            row[j] = i == changed || j == changed ? BagDistance(i, j) : oldTable[oi * oldStride + oj];
+        }
+        for (j = nBags; j < distanceStride; j++)
+            row[j] = 0.0;
+
+        n = 0;
+        if (i != changed)
+        {
+                // The old list without 'removed' and 'changed', renumbered
+            unsigned char *old = oldNeighbours + oi * (oldBags - 1);
+            for (k = 0; k < oldBags - 1; k++)
+            {
+                int b = old[k];
+                if (b == removed || b == changed)
+                    continue;
+                list[n++] = (unsigned char) (removed >= 0 && b > removed ? b - 1 : b);
+            }
+        }
+        for (j = 0; j < nBags; j++)
+        {
+            if (j == i || (i != changed && j != changed))
+                continue;
+                // Insertion in the order of ReadRoute(): by distance, then bag number
+            for (k = n; k > 0 && (row[list[k-1]] > row[j] || (row[list[k-1]] == row[j] && list[k-1] > j)); k--)
+                list[k] = list[k-1];
+            list[k] = (unsigned char) j;
+            n++;
+        }
+    }
+    free(oldTable);
+    free(oldNeighbours);
+}
+
+    // Adds a bag at 'at' as bag nBags, returns its number
+int AddBag(Coord at)
+{
+    if (nBags >= MAX_BAGS)
+    {
+        printf("Error: can't add a bag to %d bags.\n", nBags);
+        exit(-1);
+    }
+    bagCoords = (Coord*) realloc(bagCoords, (nBags + 1) * sizeof(Coord));
+    bagCoords[nBags++] = at;
+    UpdateTables(nBags - 1, nBags - 1, -1);
+    return nBags - 1;
+}
+
+    // Moves bag 'bag' to 'at'
+void MoveBag(int bag, Coord at)
+{
+    bagCoords[bag] = at;
+    UpdateTables(nBags, bag, -1);
+}
+
+    // Takes bag 'bag' out, the bags after it move down one number
+void RemoveBag(int bag)
+{
+    memmove(bagCoords + bag, bagCoords + bag + 1, (nBags - bag - 1) * sizeof(Coord));
+    nBags--;
+    UpdateTables(nBags + 1, -1, bag);
+}
+
+    // Writes the bags to 'name' in the format of route.dat
+void WriteRoute(const char *name)
+{
+    FILE *file = fopen(name, "w");
+    int i;
+
+    if (file == NULL)
+    {
+        printf("Error: couldn't write %s.\n", name);
+        return;
+    }
+    fprintf(file, "%d\n", nBags);
+    for (i = 0; i < nBags; i++)
+        fprintf(file, "%d %d\n", bagCoords[i].x, bagCoords[i].y);
+    fclose(file);
+}
+
+int ParseCount(const char *arg, int min, int max)
+{
+    const char *value = strchr(arg, '=');
+    char *end;
+    long n;
+
+    value = value != NULL ? value + 1 : arg;
+    n = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || n < min || n > max)
+    {
+        if (max == INT_MAX)
+            printf("Bad argument %s, needs a number N >= %d\n", arg, min);
+        else
+            printf("Bad argument %s, needs a number N from %d to %d\n", arg, min, max);
+        exit(-1);
+    }
+    return (int) n;
+}
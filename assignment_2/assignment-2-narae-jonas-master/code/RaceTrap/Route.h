@@ -0,0 +1,76 @@
+/*
+ * Route definition shared by all the RaceTrap variants: the grain-bag
+ * coordinates, the distance table and the route representation.
+ */
+
+#ifndef ROUTE_H
+#define ROUTE_H
+
+#include <stdio.h>
+#include <limits.h>
+
+#define MAX_BAGS 255    // Bag numbers are unsigned chars, see RaceTrapLarge for more
+
+typedef struct {
+    int x;
+    int y;
+} Coord;
+
+typedef struct {
+    double        length;     // Length of the current path (distance)
+    unsigned char nPlaced;    // Number of bags currently placed
+    unsigned char path[0];    // Array of vertex/bag numbers in the path (see comment in
+                              // Alloc_RouteDefinition())
+} RouteDefinition;
+
+extern int      nBags;          // Number of grain-bags
+extern Coord   *bagCoords;      // Coordinates for the grain-bags
+extern double  *distanceTable;  // Distances between any two grain-bags, one padded row per bag
+extern int      distanceStride; // Doubles per row of distanceTable, a multiple of 8 (64 bytes)
+extern unsigned char *neighbours; // The other bags of every bag, nearest first, nBags-1 per bag
+extern int      roundDistances; // true for distances rounded to integers like TSPLIB (EUC_2D)
+extern double   maxRouteLen;    // Initial best distance, must be longer than any possible route
+extern double   globalBest;     // Bounding variable
+
+extern int DO_DUMP;             // true if we want to dump the iterations to the file
+
+RouteDefinition *Alloc_RouteDefinition();
+
+    // Distance between bag 'i' and bag 'j'
+static inline double Distance(int i, int j)
+{
+    return distanceTable[i * distanceStride + j];
+}
+
+    // The nBags-1 other bags sorted by their distance to bag 'i'
+static inline unsigned char *Neighbours(int i)
+{
+    return neighbours + i * (nBags - 1);
+}
+
+double EuclidDist(Coord *from, Coord *to);
+
+void ReadRoute();
+
+void ReadRouteFrom(FILE *file);
+
+void FreeRoute();
+
+int AddBag(Coord at);
+
+void MoveBag(int bag, Coord at);
+
+void RemoveBag(int bag);
+
+void WriteRoute(const char *name);
+
+void dump_data(RouteDefinition *route);
+
+void close_dump();
+
+    // The number after the '=' of the command line argument 'arg'. Prints an
+    // error and exits unless it is a whole number from 'min' to 'max'
+    // (INT_MAX for no limit).
+int ParseCount(const char *arg, int min, int max);
+
+#endif
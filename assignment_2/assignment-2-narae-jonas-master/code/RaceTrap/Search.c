@@ -0,0 +1,825 @@
+/*
+ * Allocation-free branch-and-bound search engine for RaceTrap, see Search.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alloca.h>
+#include <sched.h>
+#include <omp.h>
+#include "Search.h"
+#include "Bound.h"
+#include "TransTable.h"
+#include "LeafSolver.h"
+#include "Checkpoint.h"
+#include "Timer.h"
+
+int boundMode = BOUND_NONE;
+int splitGrain = SPLIT_GRAIN;
+
+double *rootPenalty = NULL;        // Held-Karp penalties of the root, BOUND_ONETREE only
+static int ckptActive = 0;  // ShortestRoutePar() takes checkpoints (Checkpoint.h)
+long nodesExpanded = 0;
+double searchDeadline = 0.0;
+int    searchStopped = 0;
+double lowerBound = 0.0;
+
+static const char *boundNames[] = { "none", "minedge", "onetree" };
+
+    // Bound mode from its name, -1 if there is no such mode
+int ParseBoundMode(const char *name)
+{
+    int mode;
+    for (mode = BOUND_NONE; mode <= BOUND_ONETREE; mode++)
+        if (strcmp(name, boundNames[mode]) == 0)
+            return mode;
+    return -1;
+}
+
+const char *BoundModeName(int mode)
+{
+    return boundNames[mode];
+}
+
+SearchArena *Alloc_SearchArena()
+{
+    SearchArena *arena = (SearchArena*) malloc(sizeof(SearchArena));
+    int i;
+
+    arena->path   = (unsigned char*) malloc(nBags * sizeof(arena->path[0]));
+    arena->pos    = (unsigned char*) malloc(nBags * sizeof(arena->pos[0]));
+    arena->rank   = (unsigned char*) malloc(nBags * sizeof(arena->rank[0]));
+    for (i = 0; i < nBags - 1; i++)
+        arena->rank[Neighbours(0)[i]] = (unsigned char) i;
+    arena->rank[0] = 0;
+    arena->frames = (SearchFrame*) malloc((nBags + 1) * sizeof(SearchFrame));
+    arena->penalty = NULL;
+    if (boundMode == BOUND_ONETREE)
+        arena->penalty = (double*) calloc((nBags + 1) * nBags, sizeof(double));
+    arena->nodes  = 0;
+    arena->best   = Alloc_RouteDefinition();
+    arena->deque  = NULL;
+    arena->onPoll = NULL;
+    arena->progress = NULL;
+    arena->poll   = POLL_INTERVAL;
+    arena->openBound = maxRouteLen;
+    arena->open   = NULL;
+    arena->nOpen  = 0;
+    STATS(arena->stats = Alloc_SearchStats());
+    if (leafBags > 0)
+        InitLeafTables(leafBags);
+    Reset_SearchArena(arena);
+    return arena;
+}
+
+void Free_SearchArena(SearchArena *arena)
+{
+    free(arena->path);
+    free(arena->pos);
+    free(arena->rank);
+    free(arena->frames);
+    free(arena->penalty);
+    free(arena->best);
+    free(arena->open);
+    STATS(free(arena->stats));
+    free(arena);
+}
+
+    // Sets up the path that goes through each bag in turn, and forgets the best route
+void Reset_SearchArena(SearchArena *arena)
+{
+    int i;
+    for (i = 0; i < nBags; i++)
+        arena->path[i] = arena->pos[i] = (unsigned char) i;
+    arena->best->length  = maxRouteLen;
+    arena->best->nPlaced = 0;
+}
+
+    // Lower bound on a complete tour before any edge has been chosen
+double RootBound()
+{
+    int i;
+    double bound = 0.0;
+
+    switch (boundMode)
+    {
+    case BOUND_MINEDGE:
+        InitMinEdges();
+        for (i = 0; i < nBags; i++)
+            bound += firstMin(i) + secondMin(i);
+        return bound / 2;
+
+    case BOUND_ONETREE:
+        {
+            unsigned char rest[nBags];
+            for (i = 0; i < nBags; i++)
+                rest[i] = (unsigned char) i;
+            free(rootPenalty);
+            rootPenalty = (double*) calloc(nBags, sizeof(double));
+            return OneTreeBound(0, 0, rest + 1, nBags - 1, -1, rootPenalty, HK_ROOT_ITERS, ReadBest());
+        }
+
+    default:
+        return 0.0;
+    }
+}
+
+    // Lower bound for the rest of the tour after placing the bag at position
+    // 'i' at position 'depth', given the bound 'bound' of the parent. 'target'
+    // is how long the rest may be without being pruned.
+double ChildBound(SearchArena *arena, int depth, int i, double bound, double target)
+{
+    unsigned char *path = arena->path;
+    int from = path[depth-1], to = path[i];
+
+    switch (boundMode)
+    {
+    case BOUND_MINEDGE:
+        return MinEdgeChild(bound, depth, from, to);
+
+    case BOUND_ONETREE:
+        {
+                // Warm start from the penalties of the parent
+            double *pi = arena->penalty + (depth + 1) * nBags;
+            memcpy(pi, arena->penalty + depth * nBags, nBags * sizeof(double));
+            return OneTreeBound(path[0], to, path + depth, nBags - depth, i - depth,
+                                pi, HK_NODE_ITERS, target);
+        }
+
+    default:
+        return 0.0;
+    }
+}
+
+    // Lowers globalBest to 'length' unless another thread got lower first,
+    // returns true if this call lowered it. Lock-free: a compare-and-swap
+    // on the bits of the double, retried while 'length' is still better.
+int UpdateBest(double length)
+{
+    double best = ReadBest();
+
+    while (length < best)
+    {
+        if (__atomic_compare_exchange(&globalBest, &best, &length, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            return 1;
+    }
+    return 0;
+}
+
+    // True if 'length' and 'path' beat 'best'. Equal lengths are decided by
+    // the path so that every schedule of the threads ends with the same route.
+int BetterRoute(double length, unsigned char *path, RouteDefinition *best)
+{
+    if (length != best->length)
+        return length < best->length;
+    return memcmp(path, best->path, nBags) < 0;
+}
+
+    // Called with a complete path in arena->path, 'length' includes the way back home
+static void RecordRoute(SearchArena *arena, double length)
+{
+    if (!BetterRoute(length, arena->path, arena->best))
+        return;
+
+    arena->best->length  = length;
+    arena->best->nPlaced = nBags;
+    memcpy(arena->best->path, arena->path, nBags);
+
+    if (UpdateBest(length))
+    {
+        STATS(NoteImprovement(arena->stats, length));
+        if (arena->progress != NULL)
+            PushProgress(arena->progress, length, arena->path);
+    }
+}
+
+    // True once searchDeadline has passed, for every thread
+int SearchExpired()
+{
+    if (__atomic_load_n(&searchStopped, __ATOMIC_RELAXED))
+        return 1;
+        // With checkpoints the deadline is checked by CheckpointPoll(), which
+        // takes the last checkpoint before the search stops
+    if (ckptActive || searchDeadline <= 0.0 || omp_get_wtime() < searchDeadline)
+        return 0;
+    __atomic_store_n(&searchStopped, 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+    // Notes that partial routes of this 'length' and 'bound' are left unsearched
+void AbandonWork(SearchArena *arena, double length, double bound)
+{
+    if (length + bound < arena->openBound)
+        arena->openBound = length + bound;
+}
+
+    // Hands the last bags after path[0..nPlaced-1] to SolveLeaf() and records
+    // the best route it finds. The path is the same as before when it returns.
+static void FinishLeaf(SearchArena *arena, int nPlaced, double length)
+{
+    unsigned char saved[LEAF_MAX];
+    unsigned char *path = arena->path;
+    int r = nBags - nPlaced;
+    double total;
+
+    memcpy(saved, path + nPlaced, r);
+    STATS(arena->stats->leaves++);
+    total = SolveLeaf(path, nPlaced, length, arena->rank, arena->rank[path[1]]);
+    if (total <= ReadBest())
+        RecordRoute(arena, total);
+    memcpy(path + nPlaced, saved, r);
+}
+
+static int idleThreads = 0; // Threads in ShortestRoutePar looking for work
+static long pendingWork = 0; // Subproblems pushed and not yet finished
+
+    // The untried children of frame 'd' of a running SearchFrom() that is at
+    // 'depth', as a subproblem in 's'
+static void FrameWork(SearchArena *arena, int d, int depth, Subproblem *s)
+{
+    SearchFrame *frames = arena->frames;
+    unsigned char tmp;
+    int k;
+
+        // The path as it was when frame 'd' was entered: undo the swaps of the frames above it
+    memcpy(s->path, arena->path, nBags);
+    for (k = depth - 1; k >= d; k--)
+    {
+        tmp = s->path[k]; s->path[k] = s->path[frames[k].cur]; s->path[frames[k].cur] = tmp;
+    }
+    s->nPlaced = d;
+    s->next    = frames[d].next;
+    s->end     = frames[d].end;
+    s->length  = frames[d].length;
+    s->bound   = frames[d].bound;
+}
+
+/*
+ * Takes the untried children of the shallowest open frame between 'base'
+ * and 'depth' of a running SearchFrom() out of its hands, into 's'. The
+ * search won't try them. Returns false if there is nothing left to take.
+ */
+int TakeWork(SearchArena *arena, int base, int depth, Subproblem *s)
+{
+    SearchFrame *frames = arena->frames;
+    int d;
+
+    for (d = base; d <= depth && frames[d].next >= frames[d].end; d++)
+        ;
+        // The frames further down are smaller still
+    if (d > depth || nBags - d < splitGrain)
+        return 0;
+
+    FrameWork(arena, d, depth, s);
+    frames[d].next = frames[d].end;
+    return 1;
+}
+
+    // Poll hook of ShortestRoutePar: while this thread's deque holds fewer
+    // subproblems than there are idle threads, hands work over to it where
+    // they can steal it, the largest parts first.
+static void SplitWork(SearchArena *arena, int base, int depth)
+{
+    int idle = __atomic_load_n(&idleThreads, __ATOMIC_RELAXED);
+    Subproblem *s;
+
+    if (idle == 0 || WorkDeque_Size(arena->deque) >= idle)
+        return;
+    s = (Subproblem*) alloca(Subproblem_Size());
+    while (WorkDeque_Size(arena->deque) < idle && TakeWork(arena, base, depth, s))
+    {
+        __atomic_add_fetch(&pendingWork, 1, __ATOMIC_RELAXED);
+        STATS(double t0 = omp_get_wtime());
+        PushWork(arena->deque, s);
+        STATS(arena->stats->dequeTime += omp_get_wtime() - t0);
+        STATS(arena->stats->handedOver++);
+    }
+}
+
+static int  ckptRequest = 0;   // Set by the thread that finds a checkpoint due
+static int  ckptFinal = 0;     // The checkpoint was asked for at the deadline
+static int  ckptArrived = 0;   // Threads waiting for the checkpoint
+static int  ckptRound = 0;     // Bumped when it is taken, which releases them
+static int  ckptThreads;
+static long ckptNodes;         // Nodes of the runs before, when resuming
+static double ckptNext;        // omp_get_wtime() to take the next checkpoint at
+static double ckptAsked;       // omp_get_wtime() the checkpoint was asked for at
+static SearchArena **ckptArenas;
+static WorkDeque *ckptDeques;
+
+    // Called by the last thread to arrive: collects the open frames of every
+    // arena and the subproblems of every deque and writes them out
+static void TakeCheckpoint()
+{
+    size_t size = Subproblem_Size();
+    RouteDefinition *best = ckptArenas[0]->best;
+    long nWork = 0, nodes = ckptNodes;
+    char *work;
+    int t;
+
+    for (t = 0; t < ckptThreads; t++)
+        nWork += ckptArenas[t]->nOpen + WorkDeque_Size(&ckptDeques[t]);
+    work = (char*) malloc((nWork + 1) * size);
+    nWork = 0;
+    for (t = 0; t < ckptThreads; t++)
+    {
+        SearchArena *arena = ckptArenas[t];
+        memcpy(work + nWork * size, arena->open, arena->nOpen * size);
+        nWork += arena->nOpen;
+        nWork += CopyWork(&ckptDeques[t], work + nWork * size);
+        nodes += arena->nodes;
+        if (BetterRoute(arena->best->length, arena->best->path, best))
+            best = arena->best;
+    }
+    WriteCheckpoint(best, work, nWork, nodes);
+    free(work);
+    checkpointPause += omp_get_wtime() - ckptAsked;
+    ckptNext = omp_get_wtime() + checkpointInterval;
+    if (ckptFinal)
+        __atomic_store_n(&searchStopped, 1, __ATOMIC_RELAXED);
+}
+
+    // Waits at a checkpoint with the open frames base..depth of a running
+    // SearchFrom() (none if depth < base) until every thread has arrived
+static void JoinCheckpoint(SearchArena *arena, int base, int depth)
+{
+    int round = __atomic_load_n(&ckptRound, __ATOMIC_ACQUIRE);
+    int d;
+    STATS(double t0 = omp_get_wtime());
+
+    arena->nOpen = 0;
+    for (d = base; d <= depth; d++)
+        if (arena->frames[d].next < arena->frames[d].end)
+            FrameWork(arena, d, depth, (Subproblem*) (arena->open + arena->nOpen++ * Subproblem_Size()));
+
+    if (__atomic_add_fetch(&ckptArrived, 1, __ATOMIC_ACQ_REL) == ckptThreads)
+    {
+        TakeCheckpoint();
+        ckptArrived = 0;
+        __atomic_store_n(&ckptRequest, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&ckptRound, round + 1, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        while (__atomic_load_n(&ckptRound, __ATOMIC_ACQUIRE) == round)
+            sched_yield();
+    }
+    STATS(arena->stats->checkpointTime += omp_get_wtime() - t0);
+}
+
+    // Poll of a searching thread: asks for a checkpoint when one is due, or
+    // at the deadline, and joins it once asked for. Only threads with work
+    // ask, so no thread leaves ShortestRoutePar() while the others wait.
+static void CheckpointPoll(SearchArena *arena, int base, int depth)
+{
+    if (!__atomic_load_n(&ckptRequest, __ATOMIC_ACQUIRE) && !__atomic_load_n(&searchStopped, __ATOMIC_RELAXED))
+    {
+        double now = omp_get_wtime();
+        int final = searchDeadline > 0.0 && now >= searchDeadline;
+        int zero = 0;
+
+        if (((now >= ckptNext && !CheckpointBusy()) || final) &&
+            __atomic_compare_exchange_n(&ckptRequest, &zero, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+            ckptFinal = final;
+            ckptAsked = now;
+        }
+    }
+    if (__atomic_load_n(&ckptRequest, __ATOMIC_ACQUIRE))
+        JoinCheckpoint(arena, base, depth);
+}
+
+#ifdef SEARCH_STATS
+    // Counts a child of 'depth' pruned for 'reason' and gives 'res'
+#define PRUNED(arena, depth, reason, res) (Pruned((arena)->stats, depth, reason), res)
+#else
+#define PRUNED(arena, depth, reason, res) (res)
+#endif
+
+    // Place in the neighbour list of bag 0 of the nearest bag from place 'k' on
+    // that is neither placed before position 'depth' nor 'skip', nBags-1 if none
+static inline int NextHome(SearchArena *arena, int k, int depth, int skip)
+{
+    unsigned char *list = Neighbours(0);
+
+    while (k < nBags - 1 && (arena->pos[list[k]] < depth || list[k] == skip))
+        k++;
+    return k;
+}
+
+/*
+ * Sets up frame 'nPlaced' of arena->frames for a search of the children of
+ * the partial route arena->path[0..nPlaced-1] at entries next..end-1 of the
+ * neighbour list of its last bag, see SearchFrom(). Also finds the position
+ * of every bag of the path.
+ */
+void OpenFrame(SearchArena *arena, int nPlaced, int next, int end, double length, double bound)
+{
+    unsigned char *path = arena->path;
+    SearchFrame *f = &arena->frames[nPlaced];
+    int i;
+
+    for (i = 0; i < nBags; i++)
+        arena->pos[path[i]] = (unsigned char) i;
+
+    if (boundMode == BOUND_ONETREE)
+        memcpy(arena->penalty + nPlaced * nBags, rootPenalty, nBags * sizeof(double));
+
+    f->length = length;
+    f->bound  = bound;
+    f->next   = next;
+    f->end    = end;
+    if (nPlaced >= 2)
+        f->home = NextHome(arena, arena->rank[path[1]] + 1, nPlaced, -1);
+    f->mask = 0;
+    for (i = 0; i < nPlaced; i++)
+        f->mask |= (uint64_t) 1 << (path[i] & 63);
+}
+
+/*
+ * Looks at the bag at position 'i' as the next bag of the partial route
+ * path[0..depth-1] of frame 'depth'. Returns CHILD_OPEN, with the length,
+ * bound, home and mask of the child in 'child', if its subtree has to be
+ * searched. Otherwise the child was pruned, or recorded if it completes
+ * the route, and CHILD_FAR means that so are the bags further down the
+ * neighbour list.
+ */
+int TryChild(SearchArena *arena, int depth, int i, SearchFrame *child)
+{
+    unsigned char *path = arena->path;
+    unsigned char *rank = arena->rank;
+    SearchFrame *f = &arena->frames[depth];
+
+        // Every tour is also found backwards, so only the direction that
+        // leaves bag 0 for a nearer bag than it comes home from is searched.
+        // One of the bags further from bag 0 than path[1] has to be left for the end.
+    int newHome;
+    if (depth == 1)
+        newHome = rank[path[i]] + 1;
+    else if (rank[path[i]] == f->home)
+        newHome = NextHome(arena, f->home + 1, depth, path[i]);
+    else
+        newHome = f->home;
+    if (depth + 1 < nBags ? newHome >= nBags - 1 : rank[path[i]] < rank[path[1]])
+        return CHILD_DONE;
+    arena->nodes++;
+    STATS(arena->stats->expanded[depth+1]++);
+    double newLength = f->length + Distance(path[depth-1], path[i]);
+
+        // There is no point in branching along a path that can't become
+        // shorter than the current best complete route. Routes as long as
+        // the best one are kept, to pick the same one among equals every run.
+        // The bags further down the list are further away, so they are done too.
+    if (newLength > ReadBest())
+        return PRUNED(arena, depth + 1, PRUNE_LENGTH, CHILD_FAR);
+        // The way back home is at least as long as from the nearest bag it may come from
+    if (depth + 1 < nBags && newLength + Distance(0, Neighbours(0)[newHome]) > ReadBest())
+        return PRUNED(arena, depth + 1, PRUNE_HOME, CHILD_DONE);
+    uint64_t newMask = f->mask | (uint64_t) 1 << (path[i] & 63);
+    if (depth + 1 >= TT_MIN_PLACED && depth + 1 <= ttDepth && depth + 1 < nBags &&
+        Dominated(newMask, path[i], path[1], depth + 1, newLength))
+        return PRUNED(arena, depth + 1, PRUNE_DOMINATED, CHILD_DONE);
+    double newBound = ChildBound(arena, depth, i, f->bound, ReadBest() - newLength);
+    if (newLength + newBound > ReadBest())
+        return PRUNED(arena, depth + 1, PRUNE_BOUND, CHILD_DONE);
+
+    if (depth + 1 == nBags)
+    {
+            // Last bag, 'i' == 'depth' so the path is already in place
+        RecordRoute(arena, newLength + Distance(path[i], path[0]));
+        return CHILD_DONE;
+    }
+
+    child->length = newLength;
+    child->bound  = newBound;
+    child->home   = newHome;
+    child->mask   = newMask;
+    return CHILD_OPEN;
+}
+
+/*
+ * A Traveling Salesman Solver using branch-and-bound.
+ *
+ * Searches every route that starts with arena->path[0..nPlaced-1] and has
+ * one of the bags at entries next..end-1 of the neighbour list of the last
+ * placed bag at position nPlaced (end is nBags-1 for all of them), where
+ * 'length' is the length of the partial path and 'bound' a lower bound for
+ * the rest of the tour. The best complete route is kept in arena->best.
+ *
+ * Instead of recursing on a copy of the route for every child, the bag at
+ * position 'i' is swapped into position 'depth' of the one path, and swapped
+ * back when that subtree is done. arena->pos follows every swap, to find
+ * the position of the next bag of a neighbour list. The path is the same as before the call
+ * when this function returns.
+ */
+void SearchFrom(SearchArena *arena, int nPlaced, int next, int end, double length, double bound)
+{
+    unsigned char *path = arena->path;
+    unsigned char *pos  = arena->pos;
+    SearchFrame *frames = arena->frames;
+    SearchFrame *f;
+    int depth = nPlaced;
+    int i;
+    unsigned char tmp;
+
+    if (nPlaced == nBags)
+    {
+            // If all grain bags have been placed we simply add the distance to get back home (closing the loop)
+        RecordRoute(arena, length + Distance(path[nBags-1], path[0]));
+        return;
+    }
+
+    OpenFrame(arena, nPlaced, next, end, length, bound);
+
+    for (;;)
+    {
+        f = &frames[depth];
+
+        if (f->next >= f->end)
+        {
+                // All children of this frame are done, undo the swap that made it
+            if (depth == nPlaced)
+                break;
+            depth--;
+            f = &frames[depth];
+            tmp = path[depth]; path[depth] = path[f->cur]; path[f->cur] = tmp;
+            pos[path[depth]] = (unsigned char) depth;
+            pos[path[f->cur]] = (unsigned char) f->cur;
+            continue;
+        }
+
+        if (--arena->poll == 0)
+        {
+            arena->poll = POLL_INTERVAL;
+            if (ckptActive)
+                CheckpointPoll(arena, nPlaced, depth);
+            if (SearchExpired())
+            {
+                    // Out of time: leave the untried children of every frame
+                for (i = nPlaced; i <= depth; i++)
+                    if (frames[i].next < frames[i].end)
+                    {
+                        AbandonWork(arena, frames[i].length, frames[i].bound);
+                        frames[i].next = frames[i].end;
+                    }
+                continue;
+            }
+            if (arena->onPoll != NULL)
+                arena->onPoll(arena, nPlaced, depth);
+            continue;
+        }
+
+            // Try the next nearest bag to the last one that isn't placed yet as
+            // the next bag in the route (at position 'depth')
+        unsigned char *list = Neighbours(path[depth-1]);
+        do
+            i = pos[list[f->next++]];
+        while (i < depth && f->next < f->end);
+        if (i < depth)
+            continue;
+
+        int res = TryChild(arena, depth, i, &frames[depth+1]);
+        if (res == CHILD_FAR)
+            f->next = f->end;
+        if (res != CHILD_OPEN)
+            continue;
+
+            // Few enough bags left to try all their orders instead
+        if (nBags - depth - 1 <= leafBags)
+        {
+            tmp = path[depth]; path[depth] = path[i]; path[i] = tmp;
+            FinishLeaf(arena, depth + 1, frames[depth+1].length);
+            tmp = path[depth]; path[depth] = path[i]; path[i] = tmp;
+            continue;
+        }
+
+            // Swaps the position of bag # 'i' and bag # 'depth' and descends
+        f->cur = i;
+        tmp = path[depth]; path[depth] = path[i]; path[i] = tmp;
+        pos[path[depth]] = (unsigned char) depth;
+        pos[path[i]] = (unsigned char) i;
+        depth++;
+        f = &frames[depth];
+        f->next   = 0;
+        f->end    = nBags - 1;
+    }
+}
+
+void SearchRoute(SearchArena *arena, int nPlaced, double length, double bound)
+{
+    SearchFrom(arena, nPlaced, 0, nBags - 1, length, bound);
+}
+
+    // Makes 'seed' (if any) the incumbent of the search in 'arena'
+void SeedSearch(SearchArena *arena, RouteDefinition *seed)
+{
+    if (seed == NULL)
+        return;
+    memcpy(arena->best, seed, sizeof(RouteDefinition) + nBags);
+    UpdateBest(seed->length);
+}
+
+    // Sequential search from bag 0, returns the best route. 'seed' is a
+    // complete route to start from, such as HeuristicRoute(), or NULL.
+RouteDefinition *ShortestRoute(RouteDefinition *seed)
+{
+    SearchArena *arena;
+    RouteDefinition *res;
+
+        // Checkpoints need the deque, the same search on one thread
+    if (checkpointInterval > 0 || resumeSearch)
+        return ShortestRoutePar(seed);
+    arena = Alloc_SearchArena();
+    res = Alloc_RouteDefinition();
+    STATS(statsStart = omp_get_wtime());
+
+    arena->progress = Progress_Ring(0);
+    SeedSearch(arena, seed);
+    Init_TransTable(TT_MEGABYTES);
+    SearchRoute(arena, 1, 0.0, RootBound());
+    Free_TransTable();
+
+    memcpy(res, arena->best, sizeof(RouteDefinition) + nBags);
+    nodesExpanded = arena->nodes;
+    lowerBound = arena->openBound < res->length ? arena->openBound : res->length;
+    STATS(Collect_SearchStats(&arena->stats, 1, omp_get_wtime() - statsStart));
+    Free_SearchArena(arena);
+    return res;
+}
+
+/*
+ * Parallel search from bag 0 with work stealing. The whole tree starts as
+ * one subproblem in the deque of thread 0. A thread searches the
+ * subproblems of its own deque newest first, and when that is empty steals
+ * the oldest subproblem of another thread. Busy threads split their work
+ * when they see idle threads (see SplitWork()). The search is over when no
+ * subproblem is left anywhere. 'seed' is as for ShortestRoute().
+ * With resumeSearch the subproblems of the checkpoint are dealt out over
+ * the deques instead, and with checkpointInterval it takes checkpoints.
+ */
+RouteDefinition *ShortestRoutePar(RouteDefinition *seed)
+{
+    int nThreads = omp_get_max_threads();
+    SearchArena **arenas = (SearchArena**) malloc(nThreads * sizeof(SearchArena*));
+    WorkDeque *deques = (WorkDeque*) malloc(nThreads * sizeof(WorkDeque));
+    RouteDefinition *res = Alloc_RouteDefinition();
+    Subproblem *root = (Subproblem*) malloc(Subproblem_Size());
+    double rootBound;
+    long k;
+    int t, i;
+
+    STATS(statsStart = omp_get_wtime());
+    for (t = 0; t < nThreads; t++)
+    {
+        arenas[t] = Alloc_SearchArena();
+        arenas[t]->deque  = &deques[t];
+        arenas[t]->onPoll = SplitWork;
+        arenas[t]->progress = Progress_Ring(t);
+        Init_WorkDeque(&deques[t]);
+    }
+    SeedSearch(arenas[0], seed);
+    Init_TransTable(TT_MEGABYTES);
+    rootBound   = RootBound();
+    idleThreads = 0;
+    ckptNodes   = 0;
+
+    if (resumeSearch)
+    {
+        RouteDefinition *saved = Alloc_RouteDefinition();
+        char *work;
+
+        pendingWork = ReadCheckpoint(saved, &work);
+        if (saved->length < maxRouteLen && BetterRoute(saved->length, saved->path, arenas[0]->best))
+            SeedSearch(arenas[0], saved);
+        for (k = 0; k < pendingWork; k++)
+            PushWork(&deques[k % nThreads], (Subproblem*) (work + k * Subproblem_Size()));
+        ckptNodes = resumedNodes;
+        free(work);
+        free(saved);
+    }
+    else
+    {
+        for (i = 0; i < nBags; i++)
+            root->path[i] = (unsigned char) i;
+        root->nPlaced = 1;
+        root->next    = 0;
+        root->end     = nBags - 1;
+        root->length  = 0.0;
+        root->bound   = rootBound;
+        pendingWork   = 1;
+        PushWork(&deques[0], root);
+    }
+    free(root);
+
+    ckptActive = checkpointInterval > 0;
+    if (ckptActive)
+    {
+        ckptThreads = nThreads;
+        ckptArenas  = arenas;
+        ckptDeques  = deques;
+        ckptRequest = ckptArrived = 0;
+        ckptNext    = omp_get_wtime() + checkpointInterval;
+        checkpointsWritten = 0;
+        checkpointPause    = 0.0;
+        for (t = 0; t < nThreads; t++)
+            arenas[t]->open = (char*) malloc((nBags + 1) * Subproblem_Size());
+    }
+
+    #pragma omp parallel num_threads(nThreads) private(t)
+    {
+        int me = omp_get_thread_num();
+        SearchArena *arena = arenas[me];
+        Subproblem *s = (Subproblem*) malloc(Subproblem_Size());
+        int idle = 0;
+        STATS(SearchStats *stats = arena->stats);
+        STATS(double idleSince = 0.0);
+
+        for (;;)
+        {
+            if (ckptActive && __atomic_load_n(&ckptRequest, __ATOMIC_ACQUIRE))
+                JoinCheckpoint(arena, 0, -1);
+
+            STATS(double t0 = omp_get_wtime());
+            int found = PopWork(&deques[me], s);
+            STATS(stats->popped += found);
+
+            for (t = 1; !found && t < nThreads; t++)
+            {
+                found = StealWork(&deques[(me + t) % nThreads], s);
+                STATS(stats->stolen += found);
+                STATS(stats->failedSteals += !found);
+            }
+            STATS(stats->dequeTime += omp_get_wtime() - t0);
+
+            if (found && SearchExpired())
+            {
+                AbandonWork(arena, s->length, s->bound);
+                __atomic_sub_fetch(&pendingWork, 1, __ATOMIC_RELEASE);
+                continue;
+            }
+            if (found)
+            {
+                if (idle)
+                    __atomic_sub_fetch(&idleThreads, 1, __ATOMIC_RELAXED);
+                STATS(if (idle) stats->idleTime += omp_get_wtime() - idleSince);
+                idle = 0;
+                memcpy(arena->path, s->path, nBags);
+                arena->poll = POLL_INTERVAL;
+                STATS(t0 = omp_get_wtime());
+                Timer_Start("/subproblem");
+                SearchFrom(arena, s->nPlaced, s->next, s->end, s->length, s->bound);
+                Timer_Stop();
+                STATS(stats->searchTime += omp_get_wtime() - t0);
+                STATS(stats->searched++);
+                __atomic_sub_fetch(&pendingWork, 1, __ATOMIC_RELEASE);
+                continue;
+            }
+
+            if (!idle)
+                __atomic_add_fetch(&idleThreads, 1, __ATOMIC_RELAXED);
+            STATS(if (!idle) idleSince = t0);
+            idle = 1;
+            if (__atomic_load_n(&pendingWork, __ATOMIC_ACQUIRE) == 0)
+                break;
+            sched_yield();
+        }
+        STATS(if (idle) stats->idleTime += omp_get_wtime() - idleSince);
+        free(s);
+    }
+
+    res->length = maxRouteLen;
+    nodesExpanded = 0;
+    lowerBound = maxRouteLen;
+    for (t = 0; t < nThreads; t++)
+    {
+        nodesExpanded += arenas[t]->nodes;
+        if (arenas[t]->openBound < lowerBound)
+            lowerBound = arenas[t]->openBound;
+        if (BetterRoute(arenas[t]->best->length, arenas[t]->best->path, res))
+            memcpy(res, arenas[t]->best, sizeof(RouteDefinition) + nBags);
+    }
+    STATS(SearchStats *stats[nThreads]);
+    STATS(for (t = 0; t < nThreads; t++) stats[t] = arenas[t]->stats);
+    STATS(Collect_SearchStats(stats, nThreads, omp_get_wtime() - statsStart));
+    if (ckptActive)
+    {
+            // A finished search leaves a checkpoint with nothing left to do,
+            // a stopped one the checkpoint taken at the deadline
+        if (!searchStopped)
+            WriteCheckpoint(res, NULL, 0, ckptNodes + nodesExpanded);
+        Finish_Checkpoints();
+        ckptActive = 0;
+    }
+    for (t = 0; t < nThreads; t++)
+    {
+        Free_WorkDeque(&deques[t]);
+        Free_SearchArena(arenas[t]);
+    }
+    free(deques);
+    free(arenas);
+    Free_TransTable();
+    if (res->length < lowerBound)
+        lowerBound = res->length;
+    return res;
+}
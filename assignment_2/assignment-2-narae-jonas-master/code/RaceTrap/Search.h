@@ -0,0 +1,155 @@
+/*
+ * Allocation-free branch-and-bound search engine for RaceTrap.
+ *
+ * The search permutes a single path array in place: a child is made by
+ * swapping the bag to place into position nPlaced, and the swap is undone
+ * when the search backtracks. The depth-first stack is an explicit array
+ * of frames preallocated in a SearchArena, so nothing is malloc'ed or
+ * copied per node. Each thread owns one arena and only copies the path
+ * when it finds a new best route.
+ *
+ * The children of a node are tried nearest first, in the order of the
+ * neighbour list of the last placed bag (Neighbours() in Route.h), so the
+ * first dives find short routes and prune the rest of the tree early.
+ *
+ * The distances are symmetric, so each tour is searched in one direction
+ * only: the one that leaves bag 0 for a nearer bag than it comes home
+ * from, in the order of the neighbour list of bag 0. That is checked as
+ * bags are placed, a bag further away than path[1] must be left for the end,
+ * and the way home from the nearest such bag bounds the rest of the tour.
+ *
+ * The parallel search shares one incumbent length, globalBest, which is
+ * read and lowered with atomic operations only. Work is spread through
+ * per-thread work-stealing deques (WorkDeque.h): a thread that notices
+ * idle threads while its deque holds fewer subproblems than there are idle
+ * threads hands over the untried children of the shallowest open frames of
+ * its depth-first stack, one frame per idle thread. Only frames with at
+ * least splitGrain unplaced bags are handed over; below that a subtree is
+ * cheaper to search than to move, so the thread keeps it.
+ *
+ * With a deadline (searchDeadline) the search checks the clock at every
+ * poll and, once it has passed, abandons the open frames. Each of them is a
+ * set of partial routes whose length plus bound is a lower bound for its
+ * completions, so the smallest of those over all frames and subproblems not
+ * searched (and the best route) is a proven lower bound for the optimum.
+ *
+ * With checkpointInterval set (Checkpoint.h) the threads stop at their next
+ * poll once a checkpoint is due, and the last to arrive writes out the open
+ * frames of all of them and the subproblems in the deques: all the work
+ * that is left. A resumed search starts from those instead of bag 0.
+ *
+ * Built with SEARCH_STATS, every arena also counts what its thread does
+ * (SearchStats.h).
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdint.h>
+#include "Route.h"
+#include "WorkDeque.h"
+#include "Progress.h"
+#include "SearchStats.h"
+
+#define BOUND_NONE    0   // Prune on the partial path length only
+#define BOUND_MINEDGE 1   // Half-sum of the two shortest edges at every remaining bag
+#define BOUND_ONETREE 2   // Held-Karp 1-tree bound over the unvisited bags (Bound.h)
+
+#define POLL_INTERVAL 1024  // Nodes between calls of the poll hook
+#define SPLIT_GRAIN   6     // Default of splitGrain
+
+#define CHILD_OPEN 0        // TryChild(): search the subtree of the child
+#define CHILD_DONE 1        // TryChild(): pruned, or a complete route that was recorded
+#define CHILD_FAR  2        // TryChild(): pruned, and so are all further bags
+
+typedef struct {
+    double length;    // Length of path[0..depth-1]
+    double bound;     // Lower bound for the part of the tour not yet placed
+    int    next;      // Next entry of the neighbour list of path[depth-1] to try at position depth
+    int    end;       // One past the last entry to try, nBags-1 unless the frame was handed a part
+    int    cur;       // Path position that was swapped into position depth
+    int    home;      // Place in the neighbour list of bag 0 of the nearest unplaced bag
+                      // further away than path[1], the first that may end the tour (depth >= 2)
+    uint64_t mask;    // Bags in path[0..depth-1], for the dominance table (TransTable.h)
+} SearchFrame;
+
+typedef struct SearchArena SearchArena;
+
+    // Called every POLL_INTERVAL nodes by SearchFrom() with its first and
+    // current depth, for instance to hand work over with TakeWork()
+typedef void (*PollHook)(SearchArena *arena, int base, int depth);
+
+struct SearchArena {
+    unsigned char   *path;    // The one path that the search permutes in place
+    unsigned char   *pos;     // Position of every bag in path
+    unsigned char   *rank;    // Place of every bag in the neighbour list of bag 0
+    SearchFrame     *frames;  // Depth-first stack, one frame per depth
+    RouteDefinition *best;    // Best complete route found with this arena
+    double          *penalty; // Held-Karp penalties, nBags per depth (BOUND_ONETREE)
+    WorkDeque       *deque;   // Where to hand over work, NULL when searching alone
+    PollHook         onPoll;  // NULL when searching alone
+    ProgressRing    *progress; // Where to stream new best routes, NULL for nowhere
+    int              poll;    // Nodes left until the next check for idle threads
+    long             nodes;   // Number of children this arena has looked at
+    double           openBound; // Lowest bound of the work it abandoned at the deadline
+    char            *open;    // Its open frames at a checkpoint, slots of Subproblem_Size()
+    long             nOpen;
+#ifdef SEARCH_STATS
+    SearchStats     *stats;   // Counters of this arena's thread (SearchStats.h)
+#endif
+};
+
+extern int  boundMode;        // One of the BOUND_* modes above
+extern int  splitGrain;       // Fewest unplaced bags of a frame worth handing to another thread
+extern long nodesExpanded;    // Nodes looked at by the last ShortestRoute(Par)
+extern double searchDeadline; // omp_get_wtime() to stop searching at, 0 for never
+extern int    searchStopped;  // True once the deadline has passed
+extern double lowerBound;     // Proven lower bound of the last search, its route if it finished
+extern double *rootPenalty;   // Held-Karp penalties RootBound() left, BOUND_ONETREE only
+
+int ParseBoundMode(const char *name);
+
+const char *BoundModeName(int mode);
+
+SearchArena *Alloc_SearchArena();
+
+void Free_SearchArena(SearchArena *arena);
+
+void Reset_SearchArena(SearchArena *arena);
+
+double RootBound();
+
+double ChildBound(SearchArena *arena, int depth, int i, double bound, double target);
+
+static inline double ReadBest()
+{
+    double best;
+    __atomic_load(&globalBest, &best, __ATOMIC_RELAXED);
+    return best;
+}
+
+int UpdateBest(double length);
+
+int SearchExpired();
+
+void AbandonWork(SearchArena *arena, double length, double bound);
+
+int BetterRoute(double length, unsigned char *path, RouteDefinition *best);
+
+void SeedSearch(SearchArena *arena, RouteDefinition *seed);
+
+void SearchRoute(SearchArena *arena, int nPlaced, double length, double bound);
+
+void OpenFrame(SearchArena *arena, int nPlaced, int next, int end, double length, double bound);
+
+int TryChild(SearchArena *arena, int depth, int i, SearchFrame *child);
+
+void SearchFrom(SearchArena *arena, int nPlaced, int next, int end, double length, double bound);
+
+int TakeWork(SearchArena *arena, int base, int depth, Subproblem *s);
+
+RouteDefinition *ShortestRoute(RouteDefinition *seed);
+
+RouteDefinition *ShortestRoutePar(RouteDefinition *seed);
+
+#endif
@@ -0,0 +1,369 @@
+/*
+ * Distributed branch-and-bound search for RaceTrap with MPI, see SearchMPI.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "Search.h"
+#include "SearchMPI.h"
+#include "TransTable.h"
+
+enum { TAG_BEST = 1, TAG_STEAL, TAG_WORK, TAG_NOWORK, TAG_TOKEN, TAG_DONE };
+
+typedef struct {
+    long count;     // Work messages sent minus received by the ranks it passed
+    int  black;     // True if one of them received work since the last round
+} Token;
+
+typedef struct Send {
+    MPI_Request  req;
+    struct Send *next;
+    char         data[];
+} Send;
+
+static int rank, size;
+static SearchArena *arena;
+static WorkDeque deque;           // Subproblems this rank was given and has not started
+static Subproblem *msg;           // Receive buffer, big enough for any message
+static int msgBytes;
+static Send *sends = NULL;        // Non-blocking sends that may not be done yet
+static long *sent, *received;     // Messages to and from every rank
+
+static long   balance = 0;        // Work messages sent minus received by this rank
+static int    black = 0;          // Received work since the token last passed
+static int    haveToken = 0;
+static Token  token;
+static int    tokenOut = 0;       // Rank 0: the token is on its way round
+static int    stealPending = 0;   // Asked 'victim' for work and waiting for the answer
+static int    victim;
+static int    done = 0;
+static double sharedBest;         // Best length the other ranks know about
+
+    // Sends a copy of 'data' without waiting for it to arrive
+static void Post(int dest, int tag, const void *data, int bytes)
+{
+    Send *s = (Send*) malloc(sizeof(Send) + bytes);
+
+    if (bytes > 0)
+        memcpy(s->data, data, bytes);
+    MPI_Isend(s->data, bytes, MPI_BYTE, dest, tag, MPI_COMM_WORLD, &s->req);
+    s->next = sends;
+    sends = s;
+    sent[dest]++;
+}
+
+    // Frees the sends that are done, or waits for all of them
+static void Reap(int wait)
+{
+    Send **p = &sends, *s;
+    int flag;
+
+    while ((s = *p) != NULL)
+    {
+        if (wait)
+            MPI_Wait(&s->req, MPI_STATUS_IGNORE);
+        else
+            MPI_Test(&s->req, &flag, MPI_STATUS_IGNORE);
+        if (wait || flag)
+        {
+            *p = s->next;
+            free(s);
+        }
+        else
+            p = &s->next;
+    }
+}
+
+    // Tells the other ranks about a shorter route found here
+static void ShareBest()
+{
+    double best = ReadBest();
+    int r;
+
+    if (best >= sharedBest)
+        return;
+    sharedBest = best;
+    for (r = 0; r < size; r++)
+        if (r != rank)
+            Post(r, TAG_BEST, &best, sizeof(best));
+}
+
+/*
+ * Receives the message 'st' is about and acts on it. 'busy' is true when
+ * called from within SearchFrom(), whose first and current depth are
+ * 'base' and 'depth', so that a steal request can be served from its stack.
+ */
+static void Handle(MPI_Status *st, int busy, int base, int depth)
+{
+    int src = st->MPI_SOURCE;
+
+    MPI_Recv(msg, msgBytes, MPI_BYTE, src, st->MPI_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    received[src]++;
+
+    switch (st->MPI_TAG)
+    {
+    case TAG_BEST:
+        {
+            double best = *(double*) msg;
+            UpdateBest(best);
+            if (best < sharedBest)
+                sharedBest = best;
+        }
+        break;
+
+    case TAG_STEAL:
+            // The oldest subproblem of the deque is the largest, else split the running search
+        if (StealWork(&deque, msg) || (busy && TakeWork(arena, base, depth, msg)))
+        {
+            balance++;
+            Post(src, TAG_WORK, msg, Subproblem_Size());
+        }
+        else
+            Post(src, TAG_NOWORK, NULL, 0);
+        break;
+
+    case TAG_WORK:
+        balance--;
+        black = 1;
+        stealPending = 0;
+        PushWork(&deque, msg);
+        break;
+
+    case TAG_NOWORK:
+        stealPending = 0;
+        do
+            victim = (victim + 1) % size;
+        while (victim == rank);
+        break;
+
+    case TAG_TOKEN:
+        haveToken = 1;
+        token = *(Token*) msg;
+        break;
+
+    case TAG_DONE:
+        done = 1;
+        break;
+    }
+}
+
+    // Handles every message that has arrived
+static void Service(int busy, int base, int depth)
+{
+    MPI_Status st;
+    int flag;
+
+    for (;;)
+    {
+        MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, &st);
+        if (!flag)
+            return;
+        Handle(&st, busy, base, depth);
+    }
+}
+
+    // Poll hook of the search: share a new best route and answer the other ranks
+static void PollMPI(SearchArena *a, int base, int depth)
+{
+    ShareBest();
+    Service(1, base, depth);
+    Reap(0);
+}
+
+    // Called while idle: moves the token on, or on rank 0 starts a round
+    // or, when the round found every rank idle, announces the end.
+static void PassToken()
+{
+    int r;
+
+    if (rank != 0)
+    {
+        if (!haveToken)
+            return;
+        token.count += balance;
+        token.black |= black;
+        black = 0;
+        haveToken = 0;
+        Post((rank + 1) % size, TAG_TOKEN, &token, sizeof(token));
+        return;
+    }
+
+    if (haveToken)
+    {
+        haveToken = 0;
+        tokenOut = 0;
+        if (!token.black && !black && token.count + balance == 0)
+        {
+            for (r = 1; r < size; r++)
+                Post(r, TAG_DONE, NULL, 0);
+            done = 1;
+            return;
+        }
+    }
+    if (!tokenOut)
+    {
+        token.count = 0;
+        token.black = 0;
+        black = 0;
+        tokenOut = 1;
+        Post(1, TAG_TOKEN, &token, sizeof(token));
+    }
+}
+
+    // Waits until every message the other ranks sent to this one has been handled
+static void Drain()
+{
+    long *expected = (long*) malloc(size * sizeof(long));
+    MPI_Request req;
+    MPI_Status st;
+    int flag = 0, r;
+
+    while (stealPending)
+    {
+        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &st);
+        Handle(&st, 0, 0, 0);
+    }
+
+        // Nobody asks for work any more once everybody is here
+    MPI_Ibarrier(MPI_COMM_WORLD, &req);
+    while (!flag)
+    {
+        Service(0, 0, 0);
+        MPI_Test(&req, &flag, MPI_STATUS_IGNORE);
+    }
+
+    MPI_Alltoall(sent, 1, MPI_LONG, expected, 1, MPI_LONG, MPI_COMM_WORLD);
+    for (r = 0; r < size; r++)
+        while (received[r] < expected[r])
+        {
+            MPI_Probe(r, MPI_ANY_TAG, MPI_COMM_WORLD, &st);
+            Handle(&st, 0, 0, 0);
+        }
+    Reap(1);
+    free(expected);
+}
+
+    // The shortest of the routes found by all ranks, on every rank
+static RouteDefinition *BestOfAll()
+{
+    size_t bytes = sizeof(RouteDefinition) + nBags;
+    RouteDefinition *res = Alloc_RouteDefinition();
+    char *all = NULL;
+    int r;
+
+    if (rank == 0)
+        all = (char*) malloc(size * bytes);
+    MPI_Gather(arena->best, bytes, MPI_BYTE, all, bytes, MPI_BYTE, 0, MPI_COMM_WORLD);
+    if (rank == 0)
+    {
+        res->length = maxRouteLen;
+        for (r = 0; r < size; r++)
+        {
+            RouteDefinition *route = (RouteDefinition*) (all + r * bytes);
+            if (BetterRoute(route->length, route->path, res))
+                memcpy(res, route, bytes);
+        }
+        free(all);
+    }
+    MPI_Bcast(res, bytes, MPI_BYTE, 0, MPI_COMM_WORLD);
+    return res;
+}
+
+/*
+ * Searches from bag 0 over all ranks of MPI_COMM_WORLD and returns the best
+ * route on every rank. Must be called by all of them, with the same 'seed'
+ * (as for ShortestRoute(), or NULL). nodesExpanded is the sum over the ranks.
+ */
+RouteDefinition *ShortestRouteMPI(RouteDefinition *seed)
+{
+    RouteDefinition *res;
+    MPI_Status st;
+    double bound;
+    int i;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    sent     = (long*) calloc(size, sizeof(long));
+    received = (long*) calloc(size, sizeof(long));
+    msgBytes = Subproblem_Size() > sizeof(Token) ? Subproblem_Size() : sizeof(Token);
+    msg      = (Subproblem*) malloc(msgBytes);
+    victim   = (rank + 1) % size;
+    balance = black = haveToken = tokenOut = stealPending = done = 0;
+
+    arena = Alloc_SearchArena();
+    arena->onPoll = PollMPI;
+    arena->progress = Progress_Ring(0);
+    Init_WorkDeque(&deque);
+    SeedSearch(arena, seed);
+    sharedBest = ReadBest();
+    Init_TransTable(TT_MEGABYTES);
+
+        // The frontier: one subproblem per child of bag 0, nearest pushed
+        // last so that it is searched first
+    bound = RootBound();
+    for (i = nBags - 2; i >= 0; i--)
+    {
+        if (i % size != rank)
+            continue;
+        memcpy(msg->path, arena->path, nBags);
+        msg->nPlaced = 1;
+        msg->next    = (unsigned char) i;
+        msg->end     = (unsigned char) (i + 1);
+        msg->length  = 0.0;
+        msg->bound   = bound;
+        PushWork(&deque, msg);
+    }
+
+    for (;;)
+    {
+        if (PopWork(&deque, msg))
+        {
+            if (SearchExpired())
+            {
+                AbandonWork(arena, msg->length, msg->bound);
+                continue;
+            }
+            memcpy(arena->path, msg->path, nBags);
+            arena->poll = POLL_INTERVAL;
+            SearchFrom(arena, msg->nPlaced, msg->next, msg->end, msg->length, msg->bound);
+            continue;
+        }
+
+        ShareBest();
+        Service(0, 0, 0);
+        Reap(0);
+        if (WorkDeque_Size(&deque) > 0)
+            continue;
+        if (done || size == 1)
+            break;
+        PassToken();
+        if (done)
+            break;
+
+        if (!stealPending)
+        {
+            Post(victim, TAG_STEAL, NULL, 0);
+            stealPending = 1;
+        }
+            // Sleep in MPI until the answer, or anything else, arrives
+        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &st);
+        Handle(&st, 0, 0, 0);
+    }
+
+    Drain();
+    res = BestOfAll();
+    MPI_Allreduce(&arena->nodes, &nodesExpanded, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&arena->openBound, &lowerBound, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+    if (res->length < lowerBound)
+        lowerBound = res->length;
+
+    Free_TransTable();
+    Free_WorkDeque(&deque);
+    Free_SearchArena(arena);
+    free(msg);
+    free(sent);
+    free(received);
+    return res;
+}
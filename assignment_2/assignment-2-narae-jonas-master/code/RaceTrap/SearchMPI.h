@@ -0,0 +1,29 @@
+/*
+ * Distributed branch-and-bound search for RaceTrap with MPI.
+ *
+ * Every rank runs the search engine of Search.h on one thread. The
+ * children of bag 0 are the initial frontier, dealt out round-robin over
+ * the ranks. A rank that runs out of work asks the other ranks for some in
+ * turn; a busy rank answers from its poll hook with the untried children
+ * of the shallowest open frame of its search (TakeWork()).
+ *
+ * A rank that finds a shorter route sends its length to all other ranks
+ * with non-blocking sends, and every rank folds the lengths it receives
+ * into its globalBest, so all of them prune against the best route found
+ * anywhere, a poll interval late at most.
+ *
+ * The search is over when every rank is idle and no work is on its way,
+ * which is detected with Safra's token ring: the token goes round while
+ * the ranks are idle, summing how many work messages each rank sent and
+ * received and noting whether any of them received work since the token
+ * last passed. Rank 0 announces the end when a round finds nothing.
+ */
+
+#ifndef SEARCHMPI_H
+#define SEARCHMPI_H
+
+#include "Route.h"
+
+RouteDefinition *ShortestRouteMPI(RouteDefinition *seed);
+
+#endif
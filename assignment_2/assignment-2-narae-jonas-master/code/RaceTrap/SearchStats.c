@@ -0,0 +1,179 @@
+/*
+ * Statistics of a RaceTrap search, see SearchStats.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "Route.h"
+#include "Search.h"
+#include "SearchStats.h"
+
+double statsStart = 0.0;
+
+static SearchStats *collected = NULL;   // A copy of the stats of every thread of the last search
+static int    nCollected = 0;
+static double collectedTime;
+
+SearchStats *Alloc_SearchStats()
+{
+    SearchStats *stats = (SearchStats*) aligned_alloc(64, sizeof(SearchStats));
+    memset(stats, 0, sizeof(SearchStats));
+    return stats;
+}
+
+    // Keeps a copy of the stats of the 'nThreads' arenas of a search that took 'elapsed' seconds
+void Collect_SearchStats(SearchStats **stats, int nThreads, double elapsed)
+{
+    int t;
+
+    free(collected);
+    collected = (SearchStats*) aligned_alloc(64, nThreads * sizeof(SearchStats));
+    for (t = 0; t < nThreads; t++)
+        memcpy(&collected[t], stats[t], sizeof(SearchStats));
+    nCollected    = nThreads;
+    collectedTime = elapsed;
+}
+
+void NoteImprovement(SearchStats *stats, double length)
+{
+    StatsImprovement *at = &stats->improved[stats->improvements++ % STATS_IMPROVEMENTS];
+    at->time   = omp_get_wtime() - statsStart;
+    at->length = length;
+}
+
+#ifdef SEARCH_STATS
+
+    // Writes 'n' longs as a JSON array
+static void WriteLongs(FILE *file, long *values, int n)
+{
+    int i;
+
+    fprintf(file, "[");
+    for (i = 0; i < n; i++)
+        fprintf(file, "%s%ld", i ? ", " : "", values[i]);
+    fprintf(file, "]");
+}
+
+    // The kept improvements of every thread, oldest first. Returns how many
+    // there are, 'thread' gets the thread of each.
+static int MergeImprovements(StatsImprovement *out, int *thread)
+{
+    int n = 0, t, k;
+
+    for (t = 0; t < nCollected; t++)
+    {
+        SearchStats *s = &collected[t];
+        long first = s->improvements > STATS_IMPROVEMENTS ? s->improvements - STATS_IMPROVEMENTS : 0;
+        long j;
+
+        for (j = first; j < s->improvements; j++)
+        {
+                // Insertion sort by time, there are few of them
+            StatsImprovement e = s->improved[j % STATS_IMPROVEMENTS];
+            for (k = n; k > 0 && out[k-1].time > e.time; k--)
+            {
+                out[k] = out[k-1];
+                thread[k] = thread[k-1];
+            }
+            out[k] = e;
+            thread[k] = t;
+            n++;
+        }
+    }
+    return n;
+}
+
+/*
+ * Adds up the stats of the last search and writes them to 'name' as JSON:
+ * the totals, the counts per depth, the new best routes and the load of
+ * every thread. Returns false if there is nothing to write or the file
+ * can't be written.
+ */
+int WriteSearchStats(const char *name)
+{
+    long expanded[MAX_BAGS+1], pruned[MAX_BAGS+1], prunedBy[PRUNE_REASONS];
+    long total = 0, totalPruned = 0, improvements = 0;
+    StatsImprovement *merged;
+    int *thread;
+    FILE *file;
+    int t, d, i, n;
+
+    if (nCollected == 0)
+        return 0;
+    file = fopen(name, "w");
+    if (file == NULL)
+    {
+        printf("Error: couldn't write %s.\n", name);
+        return 0;
+    }
+
+    memset(expanded, 0, sizeof(expanded));
+    memset(pruned, 0, sizeof(pruned));
+    memset(prunedBy, 0, sizeof(prunedBy));
+    for (t = 0; t < nCollected; t++)
+    {
+        SearchStats *s = &collected[t];
+        for (d = 0; d <= nBags; d++)
+        {
+            expanded[d] += s->expanded[d];
+            pruned[d]   += s->pruned[d];
+            total       += s->expanded[d];
+            totalPruned += s->pruned[d];
+        }
+        for (i = 0; i < PRUNE_REASONS; i++)
+            prunedBy[i] += s->prunedBy[i];
+        improvements += s->improvements;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"bags\": %d,\n  \"bound\": \"%s\",\n  \"threads\": %d,\n  \"seconds\": %.6f,\n",
+            nBags, BoundModeName(boundMode), nCollected, collectedTime);
+    fprintf(file, "  \"expanded\": %ld,\n  \"pruned\": %ld,\n  \"prune_rate\": %.6f,\n",
+            total, totalPruned, total ? (double) totalPruned / total : 0.0);
+    fprintf(file, "  \"pruned_by\": {\"length\": %ld, \"home\": %ld, \"dominated\": %ld, \"bound\": %ld},\n",
+            prunedBy[PRUNE_LENGTH], prunedBy[PRUNE_HOME], prunedBy[PRUNE_DOMINATED], prunedBy[PRUNE_BOUND]);
+    fprintf(file, "  \"expanded_by_depth\": ");
+    WriteLongs(file, expanded, nBags + 1);
+    fprintf(file, ",\n  \"pruned_by_depth\": ");
+    WriteLongs(file, pruned, nBags + 1);
+
+    merged = (StatsImprovement*) malloc((nCollected * STATS_IMPROVEMENTS + 1) * sizeof(StatsImprovement));
+    thread = (int*) malloc((nCollected * STATS_IMPROVEMENTS + 1) * sizeof(int));
+    n = MergeImprovements(merged, thread);
+    fprintf(file, ",\n  \"improvements\": %ld,\n  \"improved\": [", improvements);
+    for (i = 0; i < n; i++)
+        fprintf(file, "%s\n    {\"seconds\": %.6f, \"length\": %.6f, \"thread\": %d}",
+                i ? "," : "", merged[i].time, merged[i].length, thread[i]);
+    fprintf(file, "%s],\n", n ? "\n  " : "");
+    free(merged);
+    free(thread);
+
+    fprintf(file, "  \"per_thread\": [");
+    for (t = 0; t < nCollected; t++)
+    {
+        SearchStats *s = &collected[t];
+        long nodes = 0;
+        for (d = 0; d <= nBags; d++)
+            nodes += s->expanded[d];
+        fprintf(file, "%s\n    {\"thread\": %d, \"expanded\": %ld, \"leaves\": %ld, \"improvements\": %ld, "
+                "\"searched\": %ld, \"popped\": %ld, \"stolen\": %ld, \"failed_steals\": %ld, \"handed_over\": %ld, "
+                "\"search_seconds\": %.6f, \"deque_seconds\": %.6f, \"checkpoint_seconds\": %.6f, \"idle_seconds\": %.6f}",
+                t ? "," : "", t, nodes, s->leaves, s->improvements, s->searched, s->popped, s->stolen,
+                s->failedSteals, s->handedOver, s->searchTime, s->dequeTime, s->checkpointTime, s->idleTime);
+    }
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+    return 1;
+}
+
+#else
+
+int WriteSearchStats(const char *name)
+{
+    printf("Search statistics are not built in, make clean; make STATS=1\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Statistics of a RaceTrap search, to tell why one instance takes longer
+ * than another.
+ *
+ * Built in only with SEARCH_STATS defined (make STATS=1); without it the
+ * STATS() statements in the search compile to nothing and SearchArena has
+ * no stats field, so the search is the same code as before.
+ *
+ * Every arena has its own SearchStats, aligned to and padded out to whole
+ * cache lines, which only its thread writes: no atomics, no sharing. They
+ * count, per depth, the children looked at and the ones pruned, why they
+ * were pruned, the new best routes with their times, the subproblems taken
+ * from the thread's own deque, stolen from another or handed over, and the
+ * time spent with the deque locks, waiting at checkpoints and idle.
+ * ShortestRoute(), ShortestRoutePar(), BestFirstRoute() and MaskRoute() copy
+ * the stats of their threads with Collect_SearchStats() before freeing them, and
+ * WriteSearchStats() adds them up and writes them out as JSON.
+ */
+
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+
+#include "Route.h"
+
+#define STATS_IMPROVEMENTS 32   // New best routes kept per thread, the last ones
+#define STATS_FILE "stats.json"
+
+#define PRUNE_LENGTH    0   // Partial path longer than the best route
+#define PRUNE_HOME      1   // No way back home short enough
+#define PRUNE_DOMINATED 2   // Dominance table (TransTable.h)
+#define PRUNE_BOUND     3   // Lower bound of the rest of the tour
+#define PRUNE_REASONS   4
+
+typedef struct {
+    double time;            // Seconds since the search started
+    double length;
+} StatsImprovement;
+
+typedef struct {
+    long   expanded[MAX_BAGS+1];  // Children looked at, by the depth of the child
+    long   pruned[MAX_BAGS+1];    // Of those, the ones pruned
+    long   prunedBy[PRUNE_REASONS];
+    long   leaves;                // Last bags handed to SolveLeaf()
+    long   improvements;          // New best routes, the last STATS_IMPROVEMENTS kept in
+    StatsImprovement improved[STATS_IMPROVEMENTS];  // improved[i % STATS_IMPROVEMENTS]
+    long   searched;              // Subproblems searched
+    long   popped;                // taken from the own deque
+    long   stolen;                // taken from another thread's deque
+    long   failedSteals;          // Deques found empty, or emptied, when stealing
+    long   handedOver;            // Subproblems this thread split off for others
+    double searchTime;            // Seconds in SearchFrom()
+    double dequeTime;             // in PushWork(), PopWork() and StealWork(), under the locks
+    double checkpointTime;        // waiting at checkpoints
+    double idleTime;              // looking for work
+} __attribute__((aligned(64))) SearchStats;
+
+#ifdef SEARCH_STATS
+#define STATS(statement) statement
+#else
+#define STATS(statement)
+#endif
+
+extern double statsStart;   // omp_get_wtime() the last search started at
+
+SearchStats *Alloc_SearchStats();
+
+void Collect_SearchStats(SearchStats **stats, int nThreads, double elapsed);
+
+void NoteImprovement(SearchStats *stats, double length);
+
+    // Counts a child at 'depth' pruned for 'reason'
+static inline void Pruned(SearchStats *stats, int depth, int reason)
+{
+    stats->pruned[depth]++;
+    stats->prunedBy[reason]++;
+}
+
+int WriteSearchStats(const char *name);
+
+#endif
@@ -0,0 +1,302 @@
+/*
+ * Named, nestable timing regions for RaceTrap, see Timer.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+#include "Timer.h"
+
+#define TIMER_PATH 128
+
+int timerBackend = TIMER_MONOTONIC;
+
+typedef struct {
+    const char *name;
+    int       parent;           // Index of the enclosing region, -1 for none
+    char      path[TIMER_PATH]; // Names from the outermost region, separated by '/'
+    long      count;
+    uint64_t *samples;          // Ticks of every run
+    long      capacity;
+} TimerRegion;
+
+typedef struct {
+    TimerRegion regions[TIMER_REGIONS];
+    int         nRegions;
+    int         open[TIMER_DEPTH];      // Regions open, innermost last, -1 for one that didn't fit
+    uint64_t    started[TIMER_DEPTH];   // Ticks they were opened at
+    int         depth;
+} TimerThread;
+
+static __thread TimerThread *me = NULL;
+static TimerThread **threads = NULL;    // Every thread that has timed something
+static int    nThreads = 0;
+static pthread_mutex_t threadsLock = PTHREAD_MUTEX_INITIALIZER;
+static double ticksPerSecond = 1e9;
+
+static const char *backendNames[] = { "monotonic", "tsc" };
+
+    // Backend from its name, -1 if there is no such backend
+int ParseTimerBackend(const char *name)
+{
+    int backend;
+    for (backend = TIMER_MONOTONIC; backend <= TIMER_TSC; backend++)
+        if (strcmp(name, backendNames[backend]) == 0)
+            return backend;
+    return -1;
+}
+
+static inline uint64_t MonotonicTicks()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static inline uint64_t Ticks()
+{
+#ifdef HAVE_TSC
+    if (timerBackend == TIMER_TSC)
+        return __rdtsc();
+#endif
+    return MonotonicTicks();
+}
+
+    // Picks the clock, before any thread starts timing
+void Init_Timers(int backend)
+{
+    timerBackend   = TIMER_MONOTONIC;
+    ticksPerSecond = 1e9;
+#ifdef HAVE_TSC
+    if (backend == TIMER_TSC)
+    {
+        struct timespec wait = { 0, TIMER_CALIBRATE * 1000000L };
+        uint64_t ns = MonotonicTicks(), tsc = __rdtsc();
+
+        nanosleep(&wait, NULL);
+        ticksPerSecond = (double) (__rdtsc() - tsc) * 1e9 / (MonotonicTicks() - ns);
+        timerBackend = TIMER_TSC;
+    }
+#else
+    if (backend == TIMER_TSC)
+        printf("No time-stamp counter on this machine, timing with the monotonic clock\n");
+#endif
+}
+
+    // The buffer of the calling thread, made and registered the first time
+static TimerThread *ThisThread()
+{
+    if (me != NULL)
+        return me;
+    me = (TimerThread*) calloc(1, sizeof(TimerThread));
+    pthread_mutex_lock(&threadsLock);
+    threads = (TimerThread**) realloc(threads, (nThreads + 1) * sizeof(TimerThread*));
+    threads[nThreads++] = me;
+    pthread_mutex_unlock(&threadsLock);
+    return me;
+}
+
+    // Index of region 'name' in 'parent' of thread 't', made if new, -1 if there is no room
+static int FindRegion(TimerThread *t, int parent, const char *name)
+{
+    TimerRegion *r;
+    int i;
+
+    for (i = 0; i < t->nRegions; i++)
+        if (t->regions[i].parent == parent &&
+            (t->regions[i].name == name || strcmp(t->regions[i].name, name) == 0))
+            return i;
+    if (t->nRegions == TIMER_REGIONS)
+        return -1;
+
+    r = &t->regions[t->nRegions];
+    r->name   = name;
+    r->parent = parent;
+    r->path[0] = '\0';
+    if (parent >= 0 && strlen(t->regions[parent].path) < TIMER_PATH - 1)
+    {
+        strcpy(r->path, t->regions[parent].path);
+        strcat(r->path, "/");
+    }
+    strncat(r->path, name, TIMER_PATH - 1 - strlen(r->path));
+    return t->nRegions++;
+}
+
+    // Opens region 'name', which has to stay valid until Timer_Report(). A
+    // name that starts with '/' is put at the outermost level (see Timer.h).
+void Timer_Start(const char *name)
+{
+    TimerThread *t = ThisThread();
+    int parent = -1;
+
+    if (t->depth == TIMER_DEPTH)
+    {
+        printf("Error: timer regions nested deeper than %d at %s.\n", TIMER_DEPTH, name);
+        exit(-1);
+    }
+    if (name[0] == '/')
+        t->open[t->depth] = FindRegion(t, -1, name + 1);
+    else
+    {
+            // Inside a region that didn't fit, so does this one
+        if (t->depth > 0)
+            parent = t->open[t->depth-1];
+        t->open[t->depth] = t->depth > 0 && parent < 0 ? -1 : FindRegion(t, parent, name);
+    }
+    t->started[t->depth++] = Ticks();
+}
+
+    // Closes the innermost open region of the calling thread, returns its seconds
+double Timer_Stop()
+{
+    uint64_t now = Ticks();
+    TimerThread *t = ThisThread();
+    TimerRegion *r;
+    uint64_t ticks;
+    int i;
+
+    if (t->depth == 0)
+        return 0.0;
+    t->depth--;
+    ticks = now - t->started[t->depth];
+    i = t->open[t->depth];
+    if (i < 0)
+        return ticks / ticksPerSecond;
+
+    r = &t->regions[i];
+    if (r->count == r->capacity)
+    {
+        r->capacity = r->capacity ? 2 * r->capacity : 16;
+        r->samples  = (uint64_t*) realloc(r->samples, r->capacity * sizeof(uint64_t));
+    }
+    r->samples[r->count++] = ticks;
+    return ticks / ticksPerSecond;
+}
+
+    // Seconds spent in the regions at 'path' over all threads
+double Timer_Total(const char *path)
+{
+    uint64_t ticks = 0;
+    int t, i;
+    long k;
+
+    for (t = 0; t < nThreads; t++)
+        for (i = 0; i < threads[t]->nRegions; i++)
+        {
+            TimerRegion *r = &threads[t]->regions[i];
+            if (strcmp(r->path, path) == 0)
+                for (k = 0; k < r->count; k++)
+                    ticks += r->samples[k];
+        }
+    return ticks / ticksPerSecond;
+}
+
+static int CompareTicks(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t*) a, y = *(const uint64_t*) b;
+    return x < y ? -1 : x > y;
+}
+
+    // Milliseconds of the sample at percentile 'p' of the 'n' sorted 'samples' (nearest rank)
+static double Percentile(uint64_t *samples, long n, double p)
+{
+    long k = (long) (p * n + 0.999999);
+    if (k < 1)
+        k = 1;
+    return samples[k-1] * 1000 / ticksPerSecond;
+}
+
+/*
+ * Prints one line per path, in the order the threads first opened them
+ * (registration order of the threads), indented by depth.
+ */
+void Timer_Report(FILE *out)
+{
+    const char **done;
+    int nDone = 0, t, i, u, j, d;
+
+    for (t = 0, i = 0; t < nThreads; t++)
+        i += threads[t]->nRegions;
+    done = (const char**) malloc((i + 1) * sizeof(const char*));
+
+    fprintf(out, "%-28s %7s %9s %11s %10s %10s %10s %10s %10s\n", "region (ms)", "threads",
+            "count", "total", "min", "median", "p90", "p99", "max");
+    for (t = 0; t < nThreads; t++)
+        for (i = 0; i < threads[t]->nRegions; i++)
+        {
+            const char *path = threads[t]->regions[i].path;
+            uint64_t *samples, total = 0;
+            long n = 0, k;
+            int users = 0;
+            char label[TIMER_PATH + TIMER_DEPTH * 2];
+
+            for (j = 0; j < nDone && strcmp(done[j], path) != 0; j++)
+                ;
+            if (j < nDone)
+                continue;
+            done[nDone++] = path;
+
+                // All the samples of this path, from every thread
+            for (u = t; u < nThreads; u++)
+                for (j = 0; j < threads[u]->nRegions; j++)
+                    if (strcmp(threads[u]->regions[j].path, path) == 0)
+                    {
+                        n += threads[u]->regions[j].count;
+                        users++;
+                    }
+            samples = (uint64_t*) malloc((n + 1) * sizeof(uint64_t));
+            n = 0;
+            for (u = t; u < nThreads; u++)
+                for (j = 0; j < threads[u]->nRegions; j++)
+                {
+                    TimerRegion *r = &threads[u]->regions[j];
+                    if (strcmp(r->path, path) != 0)
+                        continue;
+                    memcpy(samples + n, r->samples, r->count * sizeof(uint64_t));
+                    n += r->count;
+                }
+            for (k = 0; k < n; k++)
+                total += samples[k];
+            qsort(samples, n, sizeof(uint64_t), CompareTicks);
+
+            for (d = 0, k = 0; path[k]; k++)
+                d += path[k] == '/';
+            snprintf(label, sizeof(label), "%*s%s", 2 * d, "", threads[t]->regions[i].name);
+            if (n == 0)
+                fprintf(out, "%-28s %7d %9d\n", label, users, 0);
+            else
+                fprintf(out, "%-28s %7d %9ld %11.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n", label, users, n,
+                        total * 1000 / ticksPerSecond, Percentile(samples, n, 0.0), Percentile(samples, n, 0.5),
+                        Percentile(samples, n, 0.9), Percentile(samples, n, 0.99), Percentile(samples, n, 1.0));
+            free(samples);
+        }
+    free(done);
+}
+
+    // 'seconds' as StopWatch wrote it, "1 min. 2 seconds 345 ms "
+void TimeString(double seconds, char *buf)
+{
+    int days    = (int) (seconds / (24 * 60 * 60));
+    int hours   = (int) (seconds / (60 * 60)) % 24;
+    int minutes = (int) (seconds / 60) % 60;
+    int secs    = (int) seconds % 60;
+    int ms      = (int) (seconds * 1000) % 1000;
+
+    buf[0] = 0;
+    if (days > 0)
+        buf += sprintf(buf, "%d days ", days);
+    if (hours > 0)
+        buf += sprintf(buf, "%d hours ", hours);
+    if (minutes > 0)
+        buf += sprintf(buf, "%d min. ", minutes);
+    if (secs > 0)
+        buf += sprintf(buf, "%d seconds ", secs);
+    sprintf(buf, "%d ms ", ms);
+}
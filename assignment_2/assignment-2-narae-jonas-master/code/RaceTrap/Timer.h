@@ -0,0 +1,53 @@
+/*
+ * Named, nestable timing regions for RaceTrap, in place of StopWatch.
+ *
+ * Timer_Start("name") opens a region inside the one the calling thread has
+ * open, if any, and Timer_Stop() closes the innermost one and returns its
+ * seconds. Every thread keeps its own regions and samples in a buffer that
+ * only it writes, so timing needs no lock once the thread has registered
+ * its buffer at its first Timer_Start(). A region is known by its path of
+ * names from the outermost region of its thread, so "solve/search" and a
+ * "search" of its own are apart, and the same path on several threads is
+ * added up. A name that starts with '/' opens its region at the outermost
+ * level whatever is open, for work that every thread of a parallel region
+ * does alike, the thread that started the region too.
+ *
+ * Timer_Report() prints, for every path, how many threads and times it ran,
+ * the total, min, median, 90th and 99th percentile and max. Call it, and
+ * Timer_Total(), once the threads are done timing.
+ *
+ * The clock is clock_gettime(CLOCK_MONOTONIC) in nanoseconds, or with
+ * TIMER_TSC the time-stamp counter of the processor, which is read without
+ * a system call; Init_Timers() calibrates it against the monotonic clock,
+ * which takes TIMER_CALIBRATE ms. Machines without one use the clock.
+ */
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdio.h>
+
+#define TIMER_MONOTONIC 0
+#define TIMER_TSC       1
+
+#define TIMER_DEPTH     16      // Regions open at once per thread
+#define TIMER_REGIONS   64      // Paths per thread
+#define TIMER_CALIBRATE 20      // Milliseconds to calibrate the TSC over
+
+extern int timerBackend;        // TIMER_MONOTONIC or TIMER_TSC
+
+int ParseTimerBackend(const char *name);
+
+void Init_Timers(int backend);
+
+void Timer_Start(const char *name);
+
+double Timer_Stop();
+
+double Timer_Total(const char *name);
+
+void Timer_Report(FILE *out);
+
+void TimeString(double seconds, char *buf);
+
+#endif
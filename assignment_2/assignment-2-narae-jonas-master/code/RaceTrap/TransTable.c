@@ -0,0 +1,101 @@
+/*
+ * Dominance table for the RaceTrap search, see TransTable.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "Route.h"
+#include "TransTable.h"
+
+int ttDepth = 0;
+
+static TransEntry *table = NULL;
+static size_t nBuckets = 0;         // A power of two
+static omp_lock_t locks[TT_STRIPES];
+
+    // Sets up an empty table of at most 'megabytes', or none if nBags is too large
+void Init_TransTable(int megabytes)
+{
+    size_t bytes = (size_t) megabytes << 20;
+    int i;
+
+    Free_TransTable();
+    if (ttDepth <= 0)
+        return;
+    if (nBags > TT_MAX_BAGS)
+    {
+        printf("Dominance table needs at most %d bags, searching without it\n", TT_MAX_BAGS);
+        ttDepth = 0;
+        return;
+    }
+
+    for (nBuckets = 1; 2 * nBuckets * TT_WAYS * sizeof(TransEntry) <= bytes; nBuckets *= 2)
+        ;
+    table = (TransEntry*) calloc(nBuckets * TT_WAYS, sizeof(TransEntry));
+    if (table == NULL)
+    {
+        printf("Error: couldn't allocate the dominance table\n");
+        exit(-1);
+    }
+    for (i = 0; i < TT_STRIPES; i++)
+        omp_init_lock(&locks[i]);
+}
+
+void Free_TransTable()
+{
+    int i;
+
+    if (table == NULL)
+        return;
+    for (i = 0; i < TT_STRIPES; i++)
+        omp_destroy_lock(&locks[i]);
+    free(table);
+    table = NULL;
+}
+
+    // Mixes the bits of the key, so that similar sets land in different buckets
+static inline uint64_t Hash(uint64_t mask, int last, int second)
+{
+    uint64_t h = mask ^ ((uint64_t) last << 58) ^ ((uint64_t) second * 0x9E3779B97F4A7C15ULL);
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+/*
+ * True if a partial route with the same key and a shorter length is in the
+ * table, so the route 'length' long can be dropped. Otherwise remembers it.
+ * Equal lengths are kept, the tie is decided by the path when they complete.
+ */
+int Dominated(uint64_t mask, int last, int second, int nPlaced, double length)
+{
+    size_t bucket = Hash(mask, last, second) & (nBuckets - 1);
+    TransEntry *e = table + bucket * TT_WAYS, *victim = e;
+    omp_lock_t *lock = &locks[bucket % TT_STRIPES];
+    int k, dominated = 0;
+
+    omp_set_lock(lock);
+    for (k = 0; k < TT_WAYS; k++)
+    {
+        if (e[k].nPlaced == nPlaced && e[k].mask == mask && e[k].last == last && e[k].second == second)
+        {
+            if (e[k].length < length)
+                dominated = 1;
+            else
+                e[k].length = length;
+            omp_unset_lock(lock);
+            return dominated;
+        }
+            // Replace an empty entry, or else the one with the most bags placed
+        if (victim->nPlaced != 0 && (e[k].nPlaced == 0 || e[k].nPlaced > victim->nPlaced))
+            victim = &e[k];
+    }
+    victim->mask    = mask;
+    victim->length  = length;
+    victim->last    = (unsigned char) last;
+    victim->second  = (unsigned char) second;
+    victim->nPlaced = (unsigned char) nPlaced;
+    omp_unset_lock(lock);
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * Dominance table for the RaceTrap search.
+ *
+ * Two partial routes that start in bag 0, leave it for the same bag,
+ * have placed the same set of bags and end in the same bag have exactly
+ * the same completions, so the longer one can never lead to a shorter
+ * tour. The table remembers the shortest length seen for every such
+ * (visited set, last bag, second bag) key and the search drops a partial
+ * route that is longer than the one in the table. The second bag is part
+ * of the key because it decides which direction of a tour is searched
+ * (see Search.h).
+ *
+ * The table is shared by all threads. It is a fixed number of buckets of
+ * TT_WAYS entries, guarded by a smaller number of striped locks. When a
+ * bucket is full the entry with the most bags placed is replaced, since a
+ * short prefix prunes a larger subtree.
+ */
+
+#ifndef TRANSTABLE_H
+#define TRANSTABLE_H
+
+#include <stdint.h>
+
+#define TT_WAYS       4     // Entries per bucket
+#define TT_STRIPES    1024  // Locks, each guards every TT_STRIPES'th bucket
+#define TT_MEGABYTES  16    // Size of the table
+#define TT_DEFAULT_DEPTH 12 // Largest number of placed bags to look up with plain 'tt'
+#define TT_MIN_PLACED 5     // Fewer placed bags can't have been placed in another order
+#define TT_MAX_BAGS   58    // The visited set and the last bag share 64 bits
+
+typedef struct {
+    uint64_t      mask;     // Bags placed, bit b for bag b
+    double        length;   // Shortest length seen for this key
+    unsigned char last;     // Last bag placed
+    unsigned char second;   // Bag placed after bag 0
+    unsigned char nPlaced;  // Number of bags placed, 0 for an empty entry
+} TransEntry;
+
+extern int ttDepth;         // Largest number of placed bags to look up, 0 for no table
+
+void Init_TransTable(int megabytes);
+
+void Free_TransTable();
+
+int Dominated(uint64_t mask, int last, int second, int nPlaced, double length);
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * Per-thread work-stealing deques of RaceTrap subproblems, see WorkDeque.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "Route.h"
+#include "WorkDeque.h"
+
+#define DEQUE_INITIAL_CAPACITY 64
+
+size_t Subproblem_Size()
+{
+        // Rounded up so that the doubles of every slot stay aligned
+    return (sizeof(Subproblem) + nBags + 7) & ~(size_t)7;
+}
+
+static inline Subproblem *Slot(WorkDeque *deque, long index)
+{
+    return (Subproblem*) (deque->items + (index % deque->capacity) * Subproblem_Size());
+}
+
+void Init_WorkDeque(WorkDeque *deque)
+{
+    omp_init_lock(&deque->lock);
+    deque->top      = 0;
+    deque->bottom   = 0;
+    deque->capacity = DEQUE_INITIAL_CAPACITY;
+    deque->items    = (char*) malloc(deque->capacity * Subproblem_Size());
+}
+
+void Free_WorkDeque(WorkDeque *deque)
+{
+    omp_destroy_lock(&deque->lock);
+    free(deque->items);
+}
+
+    // Doubles the ring buffer, must be called with the lock held
+static void Grow_WorkDeque(WorkDeque *deque)
+{
+    size_t size = Subproblem_Size();
+    char *items = (char*) malloc(2 * deque->capacity * size);
+    long i;
+
+    for (i = deque->top; i < deque->bottom; i++)
+        memcpy(items + (i - deque->top) * size, Slot(deque, i), size);
+    free(deque->items);
+    deque->items     = items;
+    deque->capacity *= 2;
+    __atomic_store_n(&deque->bottom, deque->bottom - deque->top, __ATOMIC_RELEASE);
+    __atomic_store_n(&deque->top, 0, __ATOMIC_RELEASE);
+}
+
+void PushWork(WorkDeque *deque, Subproblem *s)
+{
+    omp_set_lock(&deque->lock);
+    if (deque->bottom - deque->top == deque->capacity)
+        Grow_WorkDeque(deque);
+    memcpy(Slot(deque, deque->bottom), s, Subproblem_Size());
+    __atomic_store_n(&deque->bottom, deque->bottom + 1, __ATOMIC_RELEASE);
+    omp_unset_lock(&deque->lock);
+}
+
+    // Owner side, takes the newest subproblem
+int PopWork(WorkDeque *deque, Subproblem *s)
+{
+    int found = 0;
+
+    omp_set_lock(&deque->lock);
+    if (deque->bottom > deque->top)
+    {
+        memcpy(s, Slot(deque, deque->bottom - 1), Subproblem_Size());
+        __atomic_store_n(&deque->bottom, deque->bottom - 1, __ATOMIC_RELEASE);
+        found = 1;
+    }
+    omp_unset_lock(&deque->lock);
+    return found;
+}
+
+    // Thief side, takes the oldest subproblem
+int StealWork(WorkDeque *deque, Subproblem *s)
+{
+    int found = 0;
+
+        // Don't bother taking the lock of an empty deque
+    if (WorkDeque_Size(deque) == 0)
+        return 0;
+
+    omp_set_lock(&deque->lock);
+    if (deque->bottom > deque->top)
+    {
+        memcpy(s, Slot(deque, deque->top), Subproblem_Size());
+        __atomic_store_n(&deque->top, deque->top + 1, __ATOMIC_RELEASE);
+        found = 1;
+    }
+    omp_unset_lock(&deque->lock);
+    return found;
+}
+
+    // Unlocked estimate, only used to decide whether to look closer
+long WorkDeque_Size(WorkDeque *deque)
+{
+    return __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE) - __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+}
+
+    // Copies the subproblems of the deque, oldest first, to 'out' (slots of
+    // Subproblem_Size()) without taking them, returns how many there were
+long CopyWork(WorkDeque *deque, char *out)
+{
+    size_t size = Subproblem_Size();
+    long i, n;
+
+    omp_set_lock(&deque->lock);
+    for (i = deque->top; i < deque->bottom; i++)
+        memcpy(out + (i - deque->top) * size, Slot(deque, i), size);
+    n = deque->bottom - deque->top;
+    omp_unset_lock(&deque->lock);
+    return n;
+}
@@ -0,0 +1,50 @@
+/*
+ * Per-thread work-stealing deques of RaceTrap subproblems.
+ *
+ * The owner pushes and pops at the bottom, other threads steal from the
+ * top, so thieves get the oldest (shallowest, largest) subproblems. Every
+ * deque has its own lock and sits on its own cache lines.
+ */
+
+#ifndef WORKDEQUE_H
+#define WORKDEQUE_H
+
+#include <omp.h>
+
+    // A subtree of the search: the children of the partial route path[0..nPlaced-1]
+    // at entries next..end-1 of the neighbour list of its last bag.
+typedef struct {
+    double        length;     // Length of path[0..nPlaced-1]
+    double        bound;      // Lower bound for the rest of the tour
+    unsigned char nPlaced;    // Number of bags placed
+    unsigned char next;       // First neighbour list entry to try at position nPlaced
+    unsigned char end;        // One past the last entry to try
+    unsigned char path[0];    // Array of vertex/bag numbers, nBags long
+} Subproblem;
+
+typedef struct {
+    omp_lock_t lock;
+    long       top;           // Index of the oldest item
+    long       bottom;        // Index one past the newest item
+    long       capacity;      // Number of slots in items
+    char      *items;         // Ring buffer of Subproblem slots
+    char       pad[64];       // Keeps neighbouring deques off this cache line
+} WorkDeque;
+
+size_t Subproblem_Size();
+
+void Init_WorkDeque(WorkDeque *deque);
+
+void Free_WorkDeque(WorkDeque *deque);
+
+void PushWork(WorkDeque *deque, Subproblem *s);
+
+int PopWork(WorkDeque *deque, Subproblem *s);
+
+int StealWork(WorkDeque *deque, Subproblem *s);
+
+long WorkDeque_Size(WorkDeque *deque);
+
+long CopyWork(WorkDeque *deque, char *out);
+
+#endif
@@ -0,0 +1,105 @@
+#!/bin/sh
+# Runs every RaceTrap solver on generated instances and checks that they agree.
+#
+#   BAGS="14 18 22" KINDS="uniform clustered grid" SEEDS="1 2" THREADS="1 2 4" \
+#   BOUND=onetree RUNS=1 ./bench.sh
+#
+# For every instance (RaceTrapGen) it runs RaceTrap depth-first, best-first and
+# with dynamic programming (up to 20 bags), RaceTrapHybrid and its bitmask
+# engine cold on every thread count, and RaceTrapHybrid with a heuristic
+# thread. RaceTrapLB is the same program with another default bound, so it
+# isn't run again. It prints
+# the length, time, nodes and nodes per second of each (the best of RUNS runs),
+# when the parallel runs found their best route, and their speedup over one
+# thread. Every length has to be the same as the first one of the instance,
+# up to the last digit; the script ends with status 1 if any isn't. Run 'make'
+# first.
+
+BAGS=${BAGS:-"14 18 22"}
+KINDS=${KINDS:-"uniform clustered grid"}
+SEEDS=${SEEDS:-"1"}
+THREADS=${THREADS:-"1 2 4"}
+BOUND=${BOUND:-onetree}
+RUNS=${RUNS:-1}
+HERE=$(cd "$(dirname "$0")" && pwd)
+DIR=$(mktemp -d)
+MAXT=$(echo $THREADS | awk '{ print $NF }')
+STATUS=0
+
+cd "$DIR" || exit 1
+
+# run name threads program args... : best of RUNS runs, sets ms length nodes found
+run() {
+    ms=""
+    for r in $(seq $RUNS); do
+        out=$("$@")
+        took=$(echo "$out" | sed -n 's/.*it took \(\([0-9]*\) min\. \)\{0,1\}\(\([0-9]*\) seconds \)\{0,1\}\([0-9]*\) ms.*/\2 \4 \5/p' |
+            awk '{ if (NF == 3) print ($1 * 60 + $2) * 1000 + $3; else if (NF == 2) print $1 * 1000 + $2; else print $1 }')
+        if [ -z "$ms" ] || [ "$took" -lt "$ms" ]; then
+            ms=$took
+            length=$(echo "$out" | sed -n 's/Route length is \([0-9.]*\).*/\1/p')
+            nodes=$(echo "$out" | sed -n 's/Looked at \([0-9]*\) nodes.*/\1/p')
+            found=$(echo "$out" | sed -n 's/Best route [0-9.]* after \([0-9.]*\) ms.*/\1/p')
+        fi
+    done
+}
+
+# line mode threads base-ms : prints a record and checks the length
+line() {
+    if [ -z "$expected" ]; then
+        expected=$length
+    fi
+    check=ok
+        # The solvers add the edges up in different orders, the last digit may differ
+    if [ -z "$length" ] || awk -v a="$length" -v b="$expected" 'BEGIN { exit (a - b < 2e-6 && b - a < 2e-6) }'; then
+        check=MISMATCH
+        STATUS=1
+    fi
+    rate=$(awk -v n="$nodes" -v ms="$ms" 'BEGIN { if (n == "") print "-"; else printf "%.0f", n / (ms > 0 ? ms : 1) }')
+    speedup=$(awk -v b="$4" -v ms="$ms" 'BEGIN { if (b == "") print "-"; else printf "%.2f", b / (ms > 0 ? ms : 1) }')
+    printf "%-16s %-10s %7s %14s %8s %12s %10s %9s %8s %s\n" "$instance" "$2" "$3" "$length" "$ms" \
+        "${nodes:--}" "$rate" "${found:--}" "$speedup" "$check"
+}
+
+printf "%-16s %-10s %7s %14s %8s %12s %10s %9s %8s %s\n" instance mode threads length ms nodes nodes/ms \
+    best-ms speedup check
+for kind in $KINDS; do
+    for bags in $BAGS; do
+        for seed in $SEEDS; do
+            instance=$kind-$bags-$seed
+            expected=""
+            "$HERE/RaceTrapGen" bags=$bags seed=$seed $kind route.dat || exit 1
+
+            run "$HERE/RaceTrap" $BOUND
+            line "$instance" depth 1
+            run "$HERE/RaceTrap" bestfirst $BOUND
+            line "$instance" bestfirst 1
+            if [ "$bags" -le 20 ]; then
+                run "$HERE/RaceTrap" dp
+                line "$instance" dp 1
+            fi
+            base=""
+            for t in $THREADS; do
+                run "$HERE/RaceTrapHybrid" cold progress threads=$t $BOUND
+                if [ -z "$base" ]; then
+                    base=$ms
+                fi
+                line "$instance" hybrid $t $base
+            done
+            base=""
+            for t in $THREADS; do
+                run "$HERE/RaceTrapHybrid" cold progress mask threads=$t $BOUND
+                if [ -z "$base" ]; then
+                    base=$ms
+                fi
+                line "$instance" mask $t $base
+            done
+            if [ "$MAXT" -ge 2 ]; then
+                run "$HERE/RaceTrapHybrid" portfolio=1 threads=$MAXT $BOUND
+                line "$instance" portfolio $MAXT
+            fi
+        done
+    done
+done
+rm -rf "$DIR"
+exit $STATUS
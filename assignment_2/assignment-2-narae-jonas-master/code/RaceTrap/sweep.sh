@@ -0,0 +1,39 @@
+#!/bin/sh
+# Throughput of RaceTrapHybrid over thread counts and split grains.
+#
+#   ./sweep.sh [bags] [bound] [threads...]
+#
+# Runs a cold search of the first 'bags' bags of route.dat (20 and minedge by
+# default) for every combination and prints the time and the nodes per
+# millisecond, the best of three runs each. Run 'make RaceTrapHybrid' first.
+
+BAGS=${1:-20}
+BOUND=${2:-minedge}
+shift 2 2>/dev/null
+THREADS=${*:-"1 2 4 8"}
+GRAINS="2 4 6 8 10"
+HERE=$(cd "$(dirname "$0")" && pwd)
+DIR=$(mktemp -d)
+
+head -n $((BAGS + 1)) "$HERE/route.dat" | sed "1s/.*/$BAGS/" > "$DIR/route.dat"
+cd "$DIR" || exit 1
+
+printf "%-8s %-6s %10s %12s %12s\n" threads grain ms nodes nodes/ms
+for t in $THREADS; do
+    for g in $GRAINS; do
+        best=""
+        for run in 1 2 3; do
+            out=$("$HERE/RaceTrapHybrid" cold threads=$t grain=$g $BOUND)
+            ms=$(echo "$out" | sed -n 's/.*it took \(\([0-9]*\) seconds \)\{0,1\}\([0-9]*\) ms.*/\2 \3/p' |
+                 awk '{ print ($2 == "" ? $1 : $1 * 1000 + $2) }')
+            nodes=$(echo "$out" | sed -n 's/Looked at \([0-9]*\) nodes.*/\1/p')
+            if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then
+                best=$ms
+                bestNodes=$nodes
+            fi
+        done
+        printf "%-8s %-6s %10s %12s %12s\n" $t $g $best $bestNodes \
+            $(awk "BEGIN { printf \"%.0f\", $bestNodes / ($best > 0 ? $best : 1) }")
+    done
+done
+rm -rf "$DIR"
@@ -0,0 +1,48 @@
+/* Grid storage for FrostTrap, see FrostGrid.h.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FrostGrid.h"
+
+int grid_alloc(grid_t *g, int width, int height) {
+    size_t rows, bytes;
+
+    if (width < 3 || height < 3)
+        return -1;
+
+    // A full cache line in front of every row keeps x = 0 aligned and
+    // holds the left halo, the right halo is in the padding at the end.
+    g->width = width;
+    g->height = height;
+    g->stride = ((size_t)width + GRID_HALO + 2 * GRID_LINE - 1) / GRID_LINE * GRID_LINE;
+    rows = (size_t)height + 2 * GRID_HALO;
+    if (g->stride > SIZE_MAX / sizeof(double) / rows)
+        return -1;
+    bytes = g->stride * rows * sizeof(double);
+    if (posix_memalign((void **)&g->mem, GRID_ALIGN, bytes) != 0)
+        return -1;
+    g->cells = g->mem + GRID_HALO * g->stride + GRID_LINE;
+
+    // Zero the rows in the same static schedule as the solvers' loops, so
+    // that the pages end up near the threads that use them.
+#pragma omp parallel for schedule(static)
+    for (long r = 0; r < (long)rows; r++)
+        memset(g->mem + r * g->stride, 0, g->stride * sizeof(double));
+    return 0;
+}
+
+void grid_free(grid_t *g) {
+    free(g->mem);
+    g->mem = g->cells = NULL;
+}
+
+void grid_copy(grid_t *dst, const grid_t *src) {
+    size_t rows = (size_t)src->height + 2 * GRID_HALO;
+
+#pragma omp parallel for schedule(static)
+    for (long r = 0; r < (long)rows; r++)
+        memcpy(dst->mem + r * dst->stride, src->mem + r * src->stride,
+               src->stride * sizeof(double));
+}
@@ -0,0 +1,43 @@
+/* Grid storage for FrostTrap.
+ *
+ * A grid is width x height cells, the fixed border included, sized at run
+ * time and stored row by row: y picks the row and x the cell in it, so the
+ * inner loops over x walk memory with unit stride. Every row starts on a
+ * GRID_ALIGN byte boundary and takes a whole number of cache lines, so two
+ * threads that update different rows never write to the same line. Around
+ * the cells is a halo of GRID_HALO cells on every side; a stencil that
+ * reaches one cell past the border stays inside the allocation.
+ */
+
+#ifndef FROSTGRID_H
+#define FROSTGRID_H
+
+#include <stddef.h>
+
+#define GRID_ALIGN 64 // bytes, one cache line
+#define GRID_HALO 1   // cells of padding around the grid, at most GRID_LINE
+#define GRID_LINE (GRID_ALIGN / (int)sizeof(double)) // doubles per cache line
+
+typedef struct {
+    int width;     // cells per row, border included
+    int height;    // rows, border included
+    size_t stride; // doubles from one row to the next
+    double *mem;   // the aligned allocation, halo and padding included
+    double *cells; // cell (0, 0)
+} grid_t;
+
+/* Allocates a zeroed width x height grid. Returns 0, or -1 if the memory
+ * can't be had. */
+int grid_alloc(grid_t *g, int width, int height);
+
+void grid_free(grid_t *g);
+
+/* Copies all of 'src', border and halo too, to 'dst' of the same size. */
+void grid_copy(grid_t *dst, const grid_t *src);
+
+/* Row y of the grid, indexed by x. */
+static inline double *grid_row(const grid_t *g, int y) {
+    return g->cells + (ptrdiff_t)y * (ptrdiff_t)g->stride;
+}
+
+#endif
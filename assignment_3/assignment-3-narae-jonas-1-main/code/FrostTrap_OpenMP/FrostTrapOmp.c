@@ -13,10 +13,12 @@
 /* See main() for more details about command line arguments. A short summary is
  * as follows:
  *
- * ./FrostTrap [simple|dbuf|rb] [dump]
+ * ./FrostTrap [simple|dbuf|rb] [dump] [size=N | width=W height=H] [iters=N]
  *
- * Where the first parameter selects the algorithm and the second parameter is
- * used to dump state to files in ./data/.
+ * Where simple, dbuf or rb selects the algorithm, dump is used to dump state
+ * to files in ./data/, size, width and height set the size of the grid
+ * (300x300 by default, border included) and iters stops after that many
+ * iterations even if it hasn't converged.
  *
  */
 
@@ -27,18 +29,18 @@
 #include <string.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include "FrostGrid.h"
 
-// Map we are building
+// Map we are building, row-major (FrostGrid.h)
 // TODO: don't use global variables for the array etc.
-// We could use a "trapdata" struct instead.
 
-#define HEIGHT 300
+#define HEIGHT 300 // default size of the grid
 #define WIDTH 300
-typedef double arrtype[WIDTH][HEIGHT];
-arrtype trap_data;
-arrtype trap_data2;
+grid_t trap_data;
+grid_t trap_data2;
 
 int DO_DUMP = 0; // true if we want to dump the iterations from the file
+int max_iters = 0; // stop after this many iterations, 0 for when converged
 int filenum = 0; // used to increase the file number/name in dump_data()
 
 #ifndef _OPENMP
@@ -63,39 +65,42 @@ void dump_data() {
      */
     printf("dumping data\n");
     fp = fopen("data/frosttrap.data", "a+");
-    for (y = 1; y < HEIGHT - 1; y++) {
-        for (x = 1; x < WIDTH - 1; x++) {
-            fprintf(fp, "%.2f ", trap_data[x][y]);
+    for (y = 1; y < trap_data.height - 1; y++) {
+        double *row = grid_row(&trap_data, y);
+        for (x = 1; x < trap_data.width - 1; x++) {
+            fprintf(fp, "%.2f ", row[x]);
         }
         fprintf(fp, "\n");
     }
     fclose(fp);
 }
 
-inline double compute_new_pixel(arrtype *src, double omega, int x, int y) {
-    return (omega / 4.0) * ((*src)[x][y - 1] + (*src)[x][y + 1] +
-                            (*src)[x - 1][y] + (*src)[x + 1][y]) +
-           (1.0 - omega) * (*src)[x][y];
+/* New value of cell x of 'row', with 'above' and 'below' the rows next to it
+ * in the same grid.
+ */
+static inline double compute_new_pixel(const double *above, const double *row,
+                                       const double *below, double omega, int x) {
+    return (omega / 4.0) * (above[x] + below[x] + row[x - 1] + row[x + 1]) +
+           (1.0 - omega) * row[x];
 }
 
-void CreateTrap() {
+void CreateTrap(int width, int height) {
     int x, y;
 
-    // Initialize with 0 //
-    for (y = 0; y < HEIGHT; y++) { 
-        for (x = 0; x < WIDTH; x++) { 
-            trap_data[x][y] = 0; 
-        } 
-    } 
+    if (grid_alloc(&trap_data, width, height) != 0) {
+        printf("Can't allocate a %dx%d grid.\n", width, height);
+        exit(1);
+    }
 
     // Set up the temperature at the sides.
-    for (y = 0; y < HEIGHT; y++) {
-        trap_data[0][y] = -273.15;         // left side
-        trap_data[WIDTH - 1][y] = -273.15; // right side
+    for (y = 0; y < height; y++) {
+        double *row = grid_row(&trap_data, y);
+        row[0] = -273.15;         // left side
+        row[width - 1] = -273.15; // right side
     }
-    for (x = 0; x < WIDTH; x++) {
-        trap_data[x][0] = 40.0;             // top
-        trap_data[x][HEIGHT - 1] = -273.15; // bottom
+    for (x = 0; x < width; x++) {
+        grid_row(&trap_data, 0)[x] = 40.0;             // top
+        grid_row(&trap_data, height - 1)[x] = -273.15; // bottom
     }
 }
 
@@ -103,35 +108,35 @@ void CreateTrap() {
  */
 int solve_simple() {
     int dumpf = 0, show_freq = 100;
-    int h = HEIGHT;
-    int w = WIDTH;
+    int h = trap_data.height;
+    int w = trap_data.width;
     double epsilon = 0.001 * h * w;
     double delta = epsilon;
     double omega = 0.8; // 0.0 < omega < 2.0
     int total_iters = 0;
-        
+
     dump_data(); // Starting point
-    while (delta >= epsilon) {
+    while (delta >= epsilon && (max_iters == 0 || total_iters < max_iters)) {
         delta = 0.0;
-        # pragma omp parallel for reduction(+:delta) //default(none) shared(trap_data) firstprivate(h, w, omega)
+        # pragma omp parallel for reduction(+:delta)
         for (int y = 1; y < h - 1; y++) {
+            double *row = grid_row(&trap_data, y);
+            const double *above = row - trap_data.stride, *below = row + trap_data.stride;
             for (int x = 1; x < w - 1; x++) {
-                double old = trap_data[x][y];
-                double new = compute_new_pixel(&trap_data, omega, x, y);
-                trap_data[x][y] = new;
+                double old = row[x];
+                double new = compute_new_pixel(above, row, below, omega, x);
+                row[x] = new;
                 delta += fabs(old - new);
             }
         }
-        
         dumpf += 1;
         if (dumpf == show_freq) {
             dump_data();
             dumpf = 0;
             // printf("It %6d Delta %f epsilon %f\n", total_iters, delta, epsilon);
         }
-        total_iters += 1;    
+        total_iters += 1;
     }
-    
     dump_data(); // final result
     printf("Total iterations: %d\n", total_iters);
     return total_iters;
@@ -141,39 +146,29 @@ int solve_simple() {
  */
 int solve_rb() {
     int dumpf = 0, show_freq = 100;
-    int h = HEIGHT;
-    int w = WIDTH;
+    int h = trap_data.height;
+    int w = trap_data.width;
     double epsilon = 0.001 * h * w;
     double delta = epsilon;
     double omega = 0.8; // 0.0 < omega < 2.0
     int total_iters = 0;
 
     dump_data(); // Starting point
-    while (delta >= epsilon) {
-        delta = 0.0;  
-        if((total_iters%2)==1){ // Update red order     
-            # pragma omp parallel for reduction(+:delta) //default(none) shared(trap_data) firstprivate(h, w, omega)
-            for (int y = 1; y < h - 1; y++) {            // column is odd(k=1) | even(k=2)
-                for (int x = (y%2)?1:2; x < w - 1; x+=2) {  // row is odd(k=1) | even(k=2)
-                    double old = trap_data[x][y];
-                    double new = compute_new_pixel(&trap_data, omega, x, y);
-                    trap_data[x][y] = new;
-                    delta += fabs(old - new);
-                }
-            }
-        }
-        else{ // Update black order  
-            # pragma omp parallel for reduction(+:delta) //default(none) shared(trap_data) firstprivate(h, w, omega)
-            for (int y = 1; y < h - 1; y++) {           // column is odd(k=1) | even(k=2)
-                for (int x = (y%2)?2:1; x < w - 1; x+=2) {// row is even(k=2) | odd(k=1)
-                    double old = trap_data[x][y];
-                    double new = compute_new_pixel(&trap_data, omega, x, y);
-                    trap_data[x][y] = new;
-                    delta += fabs(old - new);
-                }
+    while (delta >= epsilon && (max_iters == 0 || total_iters < max_iters)) {
+        delta = 0.0;
+        // Odd iterations update the red cells (x + y even), even ones the black cells
+        int first = (total_iters % 2) == 1 ? 1 : 0;
+        # pragma omp parallel for reduction(+:delta)
+        for (int y = 1; y < h - 1; y++) {
+            double *row = grid_row(&trap_data, y);
+            const double *above = row - trap_data.stride, *below = row + trap_data.stride;
+            for (int x = 1 + ((y + first) % 2); x < w - 1; x += 2) {
+                double old = row[x];
+                double new = compute_new_pixel(above, row, below, omega, x);
+                row[x] = new;
+                delta += fabs(old - new);
             }
         }
-        
         dumpf += 1;
         if (dumpf == show_freq) {
             dump_data();
@@ -191,46 +186,38 @@ int solve_rb() {
  */
 int solve_dbuf() {
     int dumpf = 0, show_freq = 100;
-    int h = HEIGHT;
-    int w = WIDTH;
+    int h = trap_data.height;
+    int w = trap_data.width;
     double epsilon = 0.001 * h * w;
     double delta = epsilon;
     double omega = 0.8; // 0.0 < omega < 2.0
     int total_iters = 0;
 
-    // copy trap_data2 from trap_data
-    for (int y = 1; y < h - 1; y++){ 
-        for (int x = 1; x < w - 1; x++){ 
-            trap_data2[x][y] = trap_data[x][y]; 
-        } 
-    } 
-    
+    // The second buffer starts as a copy, border included
+    if (grid_alloc(&trap_data2, w, h) != 0) {
+        printf("Can't allocate a second %dx%d grid.\n", w, h);
+        exit(1);
+    }
+    grid_copy(&trap_data2, &trap_data);
+
     dump_data(); // Starting point
-    while (delta >= epsilon) {
+    while (delta >= epsilon && (max_iters == 0 || total_iters < max_iters)) {
         delta = 0.0;
-        if((total_iters%2)==1){ // Update first buffer
-        # pragma omp parallel for reduction(+:delta) //default(none) shared(trap_data, trap_data2) firstprivate(h, w, omega)
-            for (int y = 1; y < h - 1; y++) {
-                for (int x = 1; x < w - 1; x++) {
-                    double old = trap_data[x][y];
-                    double new = compute_new_pixel(&trap_data2, omega, x, y);
-                    trap_data[x][y] = new;
-                    delta += fabs(old - new);
-                }
-            }
-        }
-        else{ // Update second buffer
-        # pragma omp parallel for reduction(+:delta) //default(none) shared(trap_data, trap_data2) firstprivate(h, w, omega)
-            for (int y = 1; y < h - 1; y++) {
-                for (int x = 1; x < w - 1; x++) {
-                    double old = trap_data2[x][y];
-                    double new = compute_new_pixel(&trap_data, omega, x, y);
-                    trap_data2[x][y] = new;
-                    delta += fabs(old - new);
-                }
+        // Odd iterations update the first buffer from the second, even ones the other way
+        grid_t *dst = (total_iters % 2) == 1 ? &trap_data : &trap_data2;
+        grid_t *src = (total_iters % 2) == 1 ? &trap_data2 : &trap_data;
+        # pragma omp parallel for reduction(+:delta)
+        for (int y = 1; y < h - 1; y++) {
+            double *out = grid_row(dst, y);
+            const double *row = grid_row(src, y);
+            const double *above = row - src->stride, *below = row + src->stride;
+            for (int x = 1; x < w - 1; x++) {
+                double old = out[x];
+                double new = compute_new_pixel(above, row, below, omega, x);
+                out[x] = new;
+                delta += fabs(old - new);
             }
         }
-        
         dumpf += 1;
         if (dumpf == show_freq) {
             dump_data();
@@ -240,56 +227,59 @@ int solve_dbuf() {
         total_iters += 1;
     }
     dump_data(); // final result
+    grid_free(&trap_data2);
     printf("Total iterations: %d\n", total_iters);
     return total_iters;
 }
 
 int main(int argc, char **argv) {
-    char *scheme = NULL;
-    int (*cur_solver)() = NULL;
+    char *scheme = "simple";
+    int (*cur_solver)() = solve_simple;
+    int width = WIDTH, height = HEIGHT;
     char hostname[256];
 
     gethostname(hostname, 256);
 
-    CreateTrap();
-
-    // Find out which algorithm to use
-    switch (argc) {
-    case 3:
-        if (strcmp("dump", argv[2]) == 0) {
-            DO_DUMP = 1;
-        }
-    case 2:
-        if (strcmp("simple", argv[1]) == 0) {
+    // Find out which algorithm to use, and the size of the grid
+    for (int i = 1; i < argc; i++) {
+        if (strcmp("simple", argv[i]) == 0) {
             cur_solver = solve_simple;
-        } else if (strcmp("dbuf", argv[1]) == 0) {
+            scheme = argv[i];
+        } else if (strcmp("dbuf", argv[i]) == 0) {
             cur_solver = solve_dbuf;
-        } else if (strcmp("rb", argv[1]) == 0) {
+            scheme = argv[i];
+        } else if (strcmp("rb", argv[i]) == 0) {
             cur_solver = solve_rb;
+            scheme = argv[i];
+        } else if (strcmp("dump", argv[i]) == 0) {
+            DO_DUMP = 1;
+        } else if (strncmp("size=", argv[i], 5) == 0) {
+            width = height = atoi(argv[i] + 5);
+        } else if (strncmp("width=", argv[i], 6) == 0) {
+            width = atoi(argv[i] + 6);
+        } else if (strncmp("height=", argv[i], 7) == 0) {
+            height = atoi(argv[i] + 7);
+        } else if (strncmp("iters=", argv[i], 6) == 0) {
+            max_iters = atoi(argv[i] + 6);
         } else {
-            printf("Can't figure out which you want. Assuming simple.\n");
-            cur_solver = solve_simple;
-            scheme = "simple";
+            printf("Can't figure out what %s means. Ignoring it.\n", argv[i]);
         }
-        scheme = argv[1];
-        break;
-    default:
-        scheme = "simple";
-        cur_solver = solve_simple;
     }
 
     omp_set_num_threads(omp_get_max_threads()); //
-        
-    printf("Using solver %s with max-threads %d\n", scheme,
-           omp_get_max_threads());
+
+    CreateTrap(width, height);
+    printf("Using solver %s with max-threads %d on a %dx%d grid\n", scheme,
+           omp_get_max_threads(), width, height);
     long long t1 = get_usecs();
     int total_iters = cur_solver();
     long long t2 = get_usecs();
 
     // Dump something that can be parsed as python/json.
-    printf("{ 'host': '%s', 'usecs': %lld, 'secs' : %f, 'scheme' : '%s', 'max_threads' : %d, 'total_iters' : %d}\n",
+    printf("{ 'host': '%s', 'usecs': %lld, 'secs' : %f, 'scheme' : '%s', 'max_threads' : %d, 'total_iters' : %d, 'width' : %d, 'height' : %d}\n",
            hostname, t2 - t1, (t2 - t1) / 1000000.0, scheme,
-           omp_get_max_threads(), total_iters);
+           omp_get_max_threads(), total_iters, width, height);
 
+    grid_free(&trap_data);
     return 0;
 }